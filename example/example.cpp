@@ -42,8 +42,21 @@ int main(int argc, char* argv[]) {
     builder.AddText(100, 100, L"Hello!");
     builder.AddPath(200, 200, L"M 0 0 A 50 50 90 0 1 100 0 C 100 50 10 80 0 140 C -10 80 -100 50 -100 0 A 50 50 90 0 1 0 0 Z");
     EditContent::Run(output_dir + L"/EditContent.pdf", builder.Get());
-
-    ConvertRGBToCMYK(open_path, output_dir + L"/Rgb2Cmyk.pdf");
+    DocumentGenerator::Run(output_dir, resources_dir + L"/watermark.png", 100, 4);
+    DocumentGenerator::Benchmark(resources_dir + L"/watermark.png", 1000, 4, std::cout);
+    // documents are named as the generated ones above, they go to their own directory
+    if (!DirectoryExists(output_dir + L"/TemplatePages", true))
+      throw std::runtime_error("Output directory does not exist");
+    TemplatePages::Run(open_path, output_dir + L"/TemplatePages", 10, 100, 4);
+    TemplatePages::Benchmark(resources_dir + L"/watermark.png", 1000, std::cout);
+    SplitDocument::Run(open_path, L"1", output_dir, 4, std::cout);
+    SvgPath::Run({}, std::cout);
+    TextLayout::Run(output_dir + L"/TextLayout.pdf", 200, 2, TextLayout::kAlignJustify);
+    TextLayout::Benchmark(5000, std::cout);
+
+    ConvertRGBToCMYK(open_path, output_dir + L"/Rgb2Cmyk.pdf", 4, std::cout);
+    ConvertImageColors::Run(open_path, output_dir + L"/ImageRgb2Cmyk.pdf", ConvertImageColors::kRGBToCMYK, 4, std::cout);
+    ConvertImageColors::BenchmarkKernels(16, std::cout);
     
     // Accessibility and PDF Tagging samples
     MakeAccessible(open_path, output_dir + L"/MakeAccessible.pdf", 
@@ -70,17 +83,46 @@ int main(int argc, char* argv[]) {
     extract_data.extract_text_state = true;   // extract text state
     ExtractData::Run(open_path, password, config_path, std::cout, extract_data, true, kDataFormatJson);
 
+    ImageCache image_cache;             // repeated images are extracted once
+    extract_data.extract_images = true;
+    extract_data.image_cache = &image_cache;
+    ExtractData::Run(open_path, password, config_path, std::cout, extract_data, false, kDataFormatJson);
+
+    FingerprintStore fingerprint_store; // pages extracted by previous runs reuse the stored data
+    fingerprint_store.Load(output_dir + L"/fingerprints.txt");
+    extract_data.image_cache = nullptr;
+    extract_data.fingerprint_store = &fingerprint_store;
+    ExtractData::Run(open_path, password, config_path, std::cout, extract_data, false, kDataFormatJson);
+    fingerprint_store.Save(output_dir + L"/fingerprints.txt");
+    ExtractData::RunIncremental(open_path, password, output_dir + L"/ExtractData.cache.json", std::cout,
+      extract_data, 4);
+
     PdfImageParams image_params;
     ExtractImages(open_path, output_dir + L"/", 800, image_params);
+    ExtractImageStreams(open_path, output_dir + L"/", 2.0, 4);
     ExtractTables(open_path, output_dir + L"/");
+    ExtractTables(open_path, output_dir + L"/", '\t', true, true, 4);
+    ExtractText::Run(open_path, std::cout, L"", -1, "\f", 1, 4);
+    ExtractText::RunFast(open_path, std::cout, -1, true, "\n--- page {page} ---\n", 10, 4);
+    ExtractText::Benchmark(open_path, std::cout, 4);
     ExtractHighlightedText::Run(open_path, std::cout, config_path);
 
+    ZonalExtraction::Zone header_zone;
+    header_zone.name = "header";
+    header_zone.page_num = 0;
+    header_zone.rect.left = 0; header_zone.rect.bottom = 700; header_zone.rect.right = 612; header_zone.rect.top = 792;
+    ZonalExtraction::Run({ open_path }, { header_zone }, std::cout, 4);
+    TextChunks::Run(open_path, std::cout, 200, TextChunks::kBudgetTokens, 4);
+    VisualDiff::Run(open_path, output_dir + L"/AddTags.pdf", 2.0, 16, output_dir, std::cout, 4);
+
     // PDF to HTML samples
     PdfHtmlParams html_params;
     html_params.flags |= (kHtmlNoExternalCSS | kHtmlNoExternalIMG | kHtmlNoExternalJS);
     ConvertToHtml::Run(open_path, password, output_dir + L"/fixed.html", config_path, html_params, true);
     html_params.type = kPdfHtmlResponsive;
     ConvertToHtml::Run(open_path, password, output_dir + L"/responsive.html", config_path, html_params, true);
+    ConvertToMarkdown::Run(open_path, std::cout, 4);
+    ConvertToMarkdown::Benchmark(open_path, output_dir + L"/benchmark.html", std::cout, 4);
 
     PdfHtmlParams html_params_ex;
     html_params_ex.flags |= (kHtmlNoExternalCSS | kHtmlNoExternalIMG | kHtmlNoExternalJS);
@@ -107,6 +149,31 @@ int main(int argc, char* argv[]) {
     // Signing and form-filling
     DigitalSignature(open_path, output_dir + L"/DigitalSignature.pdf", resources_dir + L"/test.pfx", L"TEST_PASSWORD");
     AddWatermark(open_path, output_dir + L"/AddWatermark.pdf", resources_dir + L"/watermark.png", 0, -1, 1, false, kAlignmentLeft, kAlignmentTop, 0.0f, 0.0f, 2.0f, 0.0f, 0.5f);
+    AddWatermark(open_path, output_dir + L"/AddWatermarkOverlay.pdf", resources_dir + L"/watermark.png", 0, -1, 1, false, kAlignmentLeft, kAlignmentTop, 0.0f, 0.0f, 2.0f, 0.0f, 0.5f, true);
+    ContentOverlay::Benchmark(open_path, resources_dir + L"/watermark.png", std::cout);
+    {
+      BatchStamping::Job job;
+      job.open_path = open_path;
+      job.save_path = output_dir + L"/BatchStamping.pdf";
+      job.bates_prefix = L"ABC";
+      BatchStamping::StampParams stamp;
+      stamp.image_path = resources_dir + L"/watermark.png";
+      stamp.image_scale = 0.25f;
+      stamp.text = L"{bates}  page {page} of {pages}  {date}";
+      BatchStamping::Run({ job }, stamp, 4, std::cout);
+    }
+    {
+      std::vector<BatchStamping::Job> jobs(3);
+      for (size_t i = 0; i < jobs.size(); i++) {
+        jobs[i].open_path = open_path;
+        jobs[i].save_path = output_dir + L"/Production" + std::to_wstring(i) + L".pdf";
+        jobs[i].bates_prefix = L"PROD";
+      }
+      BatchStamping::StampParams stamp;
+      stamp.text = L"{bates}";
+      stamp.bates_page_labels = true;
+      BatchStamping::RunProduction(jobs, 1, stamp, 4, std::cout);
+    }
     ExportFormFieldValues(open_path, output_dir + L"/ExportFormFieldValues.txt");
     SetFormFieldValue(open_path, output_dir + L"/SetFormFieldValue.pdf");
     SetFieldFlags(open_path, output_dir + L"/SetFieldFlags.pdf");
@@ -125,6 +192,10 @@ int main(int argc, char* argv[]) {
     DocumentMetadata::Run(open_path, output_dir + L"/DocumentMetadata.pdf", output_dir + L"/metadata.xml");
     EmbedFonts::Run(open_path, output_dir + L"/EmbedFonts.pdf");
     SearchText::Run(open_path, output_dir + L"/SearchText.pdf", L"PDF", 0);
+    SearchText::Run(open_path, output_dir + L"/SearchTextAnnot.pdf", L"PDF", -1, SearchText::kHighlightAnnot);
+    BatchRedaction::Run(open_path, output_dir + L"/BatchRedaction.pdf", { L"PDF" }, false, 4, std::cout);
+    PhraseSearch::Run(open_path, L"purchase agreement", std::cout, -1, 4);
+    FuzzySearch::Run(open_path, L"purchase agreement", 2, std::cout, 4);
     RegisterEvent(open_path);
 
     // Regex
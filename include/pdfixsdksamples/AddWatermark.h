@@ -20,5 +20,6 @@ void AddWatermark(
     float v_value,                                    // the vertical offset value to be used when adding the watermark on a page
     float scale,                                      // the scale factor to be used when adding the watermark, with 1.0 meaning 100%
     float rotation,                                   // the counter-clockwise rotation, in degrees, to be used when adding the watermark
-    float opacity                                     // the opacity to be used when adding the watermark
+    float opacity,                                    // the opacity to be used when adding the watermark
+    bool append_only = false                          // add the watermark as a separate content stream instead of SetContent
     );
\ No newline at end of file
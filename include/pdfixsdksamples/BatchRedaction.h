@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace BatchRedaction {
+
+  // single occurrence of a pattern on a page
+  struct Match {
+    int page_num = -1;                    // page where the match was found
+    std::wstring text;                    // matched text
+    std::vector<PdfQuad> quads;           // quads of all words the match spans
+  };
+
+  // Searches all pages in parallel and collects matches of all patterns. The result is indexed by
+  // page number.
+  void FindMatches(
+    PdfDoc* doc,                                    // document to search
+    const std::vector<std::wstring>& patterns,      // list of patterns to search
+    bool use_regex,                                 // patterns are regular expressions
+    size_t thread_count,                            // max number of threads
+    std::vector<std::vector<Match>>& page_matches   // found matches per page
+  );
+
+  // Creates redaction annotation covering the match quads.
+  void CreateRedactionAnnot(PdfPage* page, const Match& match);
+
+  // Redacts all occurrences of the patterns in the document, verifies that no matched text
+  // remains in the saved document and writes throughput of each stage to the report stream.
+  void Run(
+    const std::wstring& open_path,                  // source PDF document
+    const std::wstring& save_path,                  // redacted PDF document
+    const std::vector<std::wstring>& patterns,      // list of patterns to redact
+    bool use_regex,                                 // patterns are regular expressions
+    size_t thread_count,                            // max number of threads
+    std::ostream& report                            // output stream for the processing report
+  );
+}
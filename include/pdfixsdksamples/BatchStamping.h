@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include "Pdfix.h"
+#include "ContentOverlay.h"
+
+using namespace PDFixSDK;
+
+// Stamps many documents in parallel with an image asset encoded once and with text containing
+// per-document fields. Stamps are appended as separate content streams.
+namespace BatchStamping {
+
+  struct StampParams {
+    std::wstring image_path;              // image stamp, none if empty
+    float image_scale = 1.f;              // 1 image pixel is 1 point at scale 1
+    std::wstring text;                    // text stamp with {field} placeholders, none if empty
+    double font_size = 10;                // size of the text in Helvetica
+    PdfAlignment h_align = kAlignmentRight;
+    PdfAlignment v_align = kAlignmentBottom;
+    double margin = 24;                   // distance of the stamps from the crop box edges
+    float opacity = 1.f;
+    ContentOverlay::Layer layer = ContentOverlay::kLayerOverlay;
+    bool bates_page_labels = false;       // set page labels to the Bates numbers
+  };
+
+  // One document of the batch. Built-in fields of the text are {page}, {pages}, {bates},
+  // {date} and {file}, other fields are taken from the fields map.
+  struct Job {
+    std::wstring open_path;
+    std::wstring save_path;
+    std::wstring bates_prefix;            // prefix of the Bates number
+    long long first_bates = 1;            // Bates number of the first page
+    int bates_digits = 6;                 // Bates number is padded with zeros to this width
+    std::map<std::wstring, std::wstring> fields;
+  };
+
+  // Image stamp encoded once as the only page of an in-memory PDF. Workers open their own copy
+  // of the asset and CreateXObjectFromPage copies the compressed image into each document.
+  class StampAsset {
+    std::vector<uint8_t> m_data;
+    double m_width = 0;
+    double m_height = 0;
+
+  public:
+    void Create(Pdfix* pdfix, const std::wstring& image_path);
+    bool IsEmpty() const { return m_data.empty(); }
+    double GetWidth() const { return m_width; }
+    double GetHeight() const { return m_height; }
+    // writes the asset to the memory stream and opens it, the stream must outlive the document
+    PdfDoc* Open(Pdfix* pdfix, PsStream* stream) const;
+  };
+
+  // Replaces {field} placeholders with values, unknown fields are kept.
+  std::wstring ExpandFields(const std::wstring& text, const std::map<std::wstring, std::wstring>& fields);
+
+  // Formats the Bates number of the page.
+  std::wstring FormatBates(const Job& job, int page_num);
+
+  // WinAnsiEncoding of the text, characters out of the encoding are replaced with '?'.
+  std::string EncodeWinAnsi(const std::wstring& text);
+
+  // Width of the text in Helvetica at 1pt font size.
+  double GetHelveticaWidth(const std::string& text);
+
+  // Stamps every page of the document.
+  void StampDocument(
+    PdfDoc* doc,                          // document to stamp
+    const Job& job,                       // job of the document
+    const StampParams& params,            // stamp settings
+    PdfPage* asset_page,                  // page of the opened stamp asset, nullptr for no image
+    const std::wstring& date              // value of the {date} field
+  );
+
+  // Counts pages of all documents in parallel, then assigns each job the Bates number of its
+  // first page as a prefix sum of page counts of the preceding jobs. The numbering depends only
+  // on the job order. Returns the number of pages of the set.
+  long long AssignBatesNumbers(
+    Pdfix* pdfix,                         // pdfix instance
+    std::vector<Job>& jobs,               // documents of the production
+    long long first_number,               // Bates number of the first page of the first job
+    size_t thread_count                   // max number of threads
+  );
+
+  // Replaces page labels of the document with the Bates numbers of the job. Page labels have no
+  // zero padding, the prefix is kept.
+  void SetBatesPageLabels(PdfDoc* doc, const Job& job);
+
+  void Run(
+    const std::vector<Job>& jobs,         // documents to stamp
+    const StampParams& params,            // stamp settings
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  );
+
+  // Numbers all pages of the production sequentially and stamps the documents in parallel.
+  void RunProduction(
+    std::vector<Job> jobs,                // documents of the production in numbering order
+    long long first_number,               // Bates number of the first page
+    const StampParams& params,            // stamp settings, text usually contains {bates}
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  );
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <iostream>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Adds content to pages in a separate content stream. The original content streams are neither
+// parsed nor re-serialized, as opposed to editing PdsContent and calling PdfPage::SetContent.
+namespace ContentOverlay {
+
+  enum Layer {
+    kLayerOverlay = 0,                    // drawn over the original content
+    kLayerUnderlay = 1,                   // drawn under the original content
+  };
+
+  // Writes content streams of one document. Pages modified by the writer must not be edited
+  // through PdsContent afterwards, SetContent would drop the appended stream.
+  class OverlayWriter {
+    PdfDoc* m_doc;
+    PdsStream* m_save_state = nullptr;              // "q" stream shared by all overlaid pages
+    std::map<int, PdsDictionary*> m_gstates;        // ExtGState by fill opacity in 1/1000
+
+    PdsStream* CreateContentStream(const std::string& operators);
+    PdsDictionary* GetResourceDict(PdfPage* page, const wchar_t* category);
+    void AppendOpacity(PdfPage* page, float opacity, std::string& operators);
+
+  public:
+    OverlayWriter(PdfDoc* doc);
+
+    // Appends operators drawing the XObject to the operators string and registers the XObject
+    // in resources of the page.
+    void DrawXObject(PdfPage* page, PdsStream* xobj, const PdfMatrix& matrix, float opacity,
+      std::string& operators);
+
+    // Appends operators showing the text in a simple font, the text must already be encoded for
+    // the font. The font dictionary has to be an indirect object.
+    void DrawText(PdfPage* page, PdsDictionary* font, double font_size, const PdfPoint& pos,
+      const std::string& text, float opacity, std::string& operators);
+
+    // Adds the operators as a new content stream of the page.
+    void Write(PdfPage* page, const std::string& operators, Layer layer);
+  };
+
+  // Appends a number formatted for a content stream.
+  void AppendNumber(double value, std::string& operators);
+
+  // Stamps the image on every page with both methods and reports pages/s and saved document sizes.
+  void Benchmark(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& img_path,         // image to stamp
+    std::ostream& output                  // output stream for the report
+  );
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Converts color spaces of 8-bit image XObjects. Pixels are decoded, converted by per-pixel
+// kernels written for compiler auto-vectorization and recompressed with LZW.
+namespace ConvertImageColors {
+
+  enum ColorConversion {
+    kRGBToCMYK = 0,
+    kRGBToGray = 1,
+    kCMYKToRGB = 2,
+  };
+
+  // kernels over interleaved 8-bit components, dst holds pixel_count * output components
+  void RGBToCMYK(const uint8_t* src, uint8_t* dst, size_t pixel_count);
+  void RGBToGray(const uint8_t* src, uint8_t* dst, size_t pixel_count);
+  void CMYKToRGB(const uint8_t* src, uint8_t* dst, size_t pixel_count);
+
+  // Encodes the data for the LZWDecode filter with the default EarlyChange 1.
+  void LzwEncode(const uint8_t* data, size_t size, std::vector<uint8_t>& encoded);
+
+  struct Stats {
+    size_t images = 0;                    // image XObjects referenced from page resources
+    size_t converted = 0;                 // images converted
+    size_t duplicates = 0;                // images identical to a converted one
+    size_t skipped = 0;                   // images in another color space, bit depth or codec
+                                          // and images with a color key mask
+    double megapixels = 0.;               // pixels of converted images
+    double kernel_seconds = 0.;           // time spent in the kernels, summed over threads
+    double seconds = 0.;                  // wall time of the conversion
+  };
+
+  // Converts images of all pages and their forms. Each image object is converted once, images
+  // with identical pixels and dictionary entries share one converted XObject. Images are decoded, converted and
+  // compressed in parallel, resources are updated afterwards.
+  void ConvertImages(PdfDoc* doc, ColorConversion conversion, size_t thread_count, Stats& stats);
+
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& save_path,        // output PDF document
+    ColorConversion conversion,           // conversion applied to the images
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  );
+
+  // Reports megapixels per second of each kernel on a synthetic image.
+  void BenchmarkKernels(size_t megapixels, std::ostream& output);
+}
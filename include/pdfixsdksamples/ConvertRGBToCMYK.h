@@ -1,8 +1,16 @@
 #pragma once
 
 #include <string>
+#include <iostream>
 
+// Converts DeviceRGB colors of all page objects, nested forms and axial and radial shadings to
+// DeviceCMYK. Forms, shadings and functions shared by pages are converted once in a serial pass,
+// objects of the page contents are then converted in parallel. The number of converted objects per
+// page is written to the output.
 void ConvertRGBToCMYK(
   const std::wstring& open_path,      // source PDF document
-  const std::wstring& save_path       // output PDF document
+  const std::wstring& save_path,      // output PDF document
+  size_t thread_count = 1,            // max number of threads
+  std::ostream& output = std::cout    // output stream for the report
 );
+
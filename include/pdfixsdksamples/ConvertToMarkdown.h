@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include "Pdfix.h"
+#include "PageFingerprint.h"
+
+using namespace PDFixSDK;
+
+// Lightweight Markdown export from the page map. Headings come from text styles, tables from
+// PdeTable and lists from PdeList, no PdfToHtml module is needed.
+namespace ConvertToMarkdown {
+
+  // Appends Markdown of the page, page headers and footers are skipped.
+  void GetPageMarkdown(PdfPage* page, std::string& markdown);
+
+  // Converts pages in parallel and writes each page as soon as all previous pages are written.
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    std::ostream& output,                 // output stream
+    size_t thread_count,                  // max number of threads
+    FingerprintStore* fingerprint_store = nullptr   // pages with known fingerprint reuse the stored markdown
+  );
+
+  // Compares throughput of the Markdown export and ConvertToHtml on one thread, and of the
+  // Markdown export on one and on thread_count threads.
+  void Benchmark(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& html_path,        // output HTML file of the ConvertToHtml run
+    std::ostream& output,                 // report stream
+    size_t thread_count                   // max number of threads
+  );
+}
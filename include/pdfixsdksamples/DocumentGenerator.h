@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include "Pdfix.h"
+#include "EditContent.h"
+
+using namespace PDFixSDK;
+
+// Generates large batches of single page documents (invoices, letters) from object properties.
+namespace DocumentGenerator {
+
+  // fills the builder with objects of the document with the given index
+  using BuildProc = std::function<void(size_t doc_index, EditContent::PropsBuilder& builder)>;
+
+  struct Stats {
+    size_t documents = 0;                 // number of generated documents
+    size_t objects = 0;                   // number of generated page objects
+    double seconds = 0.;                  // wall time of the generation
+    double GetDocsPerSecond() const { return seconds > 0 ? documents / seconds : 0.; }
+  };
+
+  // Creates a document with one page holding the objects. Resources are shared through a cache
+  // created for the document, or created per object when use_cache is false.
+  PdfDoc* CreateDocument(
+    Pdfix* pdfix,                                          // pdfix instance
+    const std::vector<EditContent::ObjectProps>& props,    // objects of the page
+    const PdfRect& media_box,                              // page size
+    bool use_cache                                         // share resources in the document
+  );
+
+  // Generates documents in parallel, each worker reuses its builder. Documents are saved as
+  // save_dir/document<index>.pdf, or to a discarded memory stream when save_dir is empty.
+  void Generate(
+    const std::wstring& save_dir,         // output directory
+    size_t document_count,                // number of documents to generate
+    const BuildProc& build,               // objects of each document
+    bool use_cache,                       // share resources in each document
+    size_t thread_count,                  // max number of threads
+    Stats& stats                          // generation statistics
+  );
+
+  // Objects of a sample invoice with a logo, address block, item lines and a frame.
+  void BuildInvoice(const std::wstring& logo_path, size_t doc_index, EditContent::PropsBuilder& builder);
+
+  void Run(
+    const std::wstring& save_dir,         // output directory
+    const std::wstring& logo_path,        // logo image placed on each invoice
+    size_t document_count,                // number of documents to generate
+    size_t thread_count                   // max number of threads
+  );
+
+  // Measures docs/sec of the per-object resource creation on one thread against cached
+  // resources on thread_count threads. Documents are saved to memory only.
+  void Benchmark(
+    const std::wstring& logo_path,        // logo image placed on each invoice
+    size_t document_count,                // number of documents to generate
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  );
+}
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <map>
 #include <iostream>
 #include "Pdfix.h"
 
@@ -18,23 +20,59 @@ namespace EditContent {
     std::wstring data;          // data associated with the object
   };
 
+  // Collects object properties, the data strings are moved in. A builder reused after Clear()
+  // keeps its capacity.
   class PropsBuilder {
     std::vector<ObjectProps> m_properties;
 
+    PropsBuilder& Add(double x, double y, PdfPageObjectType obj_type, std::wstring&& data);
+
   public:
-    PropsBuilder& AddText(double x, double y, const std::wstring& text);
-    PropsBuilder& AddPath(double x, double y, const std::wstring& svg);
-    PropsBuilder& AddImage(double x, double y, const std::wstring& path);
+    PropsBuilder& AddText(double x, double y, std::wstring text);
+    PropsBuilder& AddPath(double x, double y, std::wstring svg);
+    PropsBuilder& AddImage(double x, double y, std::wstring path);
+    PropsBuilder& Reserve(size_t count);
+    void Clear();
     std::vector<ObjectProps>& Get();
+    std::vector<ObjectProps> Release();    // moves the collected properties out of the builder
+  };
+
+  // Fonts, color spaces, colors and image XObjects created once per document and shared by all
+  // objects added to its pages. Colors are destroyed together with the cache.
+  class ResourceCache {
+    Pdfix* m_pdfix;
+    PdfDoc* m_doc;
+    std::map<std::pair<std::wstring, int>, PdfFont*> m_fonts;
+    std::map<PdfColorSpaceFamily, PdfColorSpace*> m_color_spaces;
+    std::map<uint32_t, PdfColor*> m_colors;           // DeviceRGB colors by 8-bit packed components
+    std::map<std::wstring, PdsStream*> m_images;      // image XObjects by file path
+
+  public:
+    ResourceCache(Pdfix* pdfix, PdfDoc* doc);
+    ResourceCache(const ResourceCache&) = delete;
+    ResourceCache& operator=(const ResourceCache&) = delete;
+    ~ResourceCache();
+
+    PdfDoc* GetDoc() const { return m_doc; }
+    PdfFont* GetFont(const std::wstring& name, int flags);
+    PdfColorSpace* GetColorSpace(PdfColorSpaceFamily family);
+    PdfColor* GetRGBColor(float r, float g, float b);
+    PdsStream* GetImage(const std::wstring& path);
   };
 
   void EditPageContent(Pdfix* pdfix, PdfDoc* doc, PdsContent* content, const std::vector<ObjectProps>& object_props);
+
+  // Same as above, the resources are taken from the document cache.
+  void EditPageContent(ResourceCache& cache, PdsContent* content, const std::vector<ObjectProps>& object_props);
   
   void AddText(Pdfix* pdfix, PdfDoc* doc, PdsContent* content, const ObjectProps& object_prop);
+  void AddText(ResourceCache& cache, PdsContent* content, const ObjectProps& object_prop);
   
   void AddPath(PdfDoc* doc, PdsContent* content, const ObjectProps& object_prop);
+  void AddPath(ResourceCache& cache, PdsContent* content, const ObjectProps& object_prop);
   
   void AddImage(Pdfix* pdfix, PdfDoc* doc, PdsContent* content, const ObjectProps& object_prop);
+  void AddImage(ResourceCache& cache, PdsContent* content, const ObjectProps& object_prop);
 
   void Run(
     const std::wstring& output_path,               // output PDF document
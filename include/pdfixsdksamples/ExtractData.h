@@ -6,6 +6,8 @@
 #include <sstream>
 #include <boost/property_tree/ptree.hpp>
 #include "Pdfix.h"
+#include "ImageCache.h"
+#include "PageFingerprint.h"
 
 using namespace PDFixSDK;
 using namespace boost::property_tree;
@@ -47,8 +49,13 @@ namespace ExtractData {
     double render_zoom = 1.;              // page rasterizing zoom of image extraction
     PdfRotate render_rotate = kRotate0;   // page rasterizing rotation of image extraction
     PdfImageFormat image_format = kImageFormatJpg;  // format of the image
+    ImageCache* image_cache = nullptr;    // repeated images are referenced by "image_ref" instead of rendered
+    FingerprintStore* fingerprint_store = nullptr;  // pages with known fingerprint reuse the stored data
   };
 
+  // hash of the options that change the extracted page data, continues the passed hash
+  uint64_t HashPageOptions(const DataType& data_types, uint64_t hash);
+
   // annotations
   void ExtractAnnot(PdfAnnot *annot, ptree &node, const DataType& data_types);
 
@@ -90,6 +97,8 @@ namespace ExtractData {
   void ExtractTextState(PdfTextState *text_state, ptree &node, const DataType &data_types);
   void ExtractGraphicState(const PdfGraphicState &graphics_state, ptree &node, const DataType &data_types);
   void RenderPageArea(PdfPage *page, PdfRect &bbox, ptree &node, const DataType &data_types);
+  bool ExtractImageRef(PdsImage *image, ptree &node, const DataType &data_types);
+  bool ExtractImageRef(PdeElement *element, ptree &node, const DataType &data_types);
 
   void Run(
       const std::wstring &open_path,    // source PDF document
@@ -100,4 +109,16 @@ namespace ExtractData {
       bool preflight,                   // make preflight before processing
       PsDataFormat format               // output format
       );       
+
+  // Extracts pages changed by incremental updates since the previous run and merges them with
+  // the cached data of unchanged pages. Output is always JSON, data_types.page_num and
+  // data_types.image_cache are ignored.
+  void RunIncremental(
+      const std::wstring &open_path,    // source PDF document
+      const std::wstring &password,     // open password
+      const std::wstring &cache_path,   // cache of the previous extraction, updated by the run
+      std::ostream &output,             // output stream
+      const DataType& data_types,       // structure containing data types to extract
+      size_t thread_count               // max number of threads
+      );
 };
@@ -2,6 +2,7 @@
 
 #include <string>
 #include "Pdfix.h"
+#include "ImageCache.h"
 
 using namespace PDFixSDK;
 
@@ -11,12 +12,28 @@ void SaveImage(PdeElement* element,
                PdfImageParams& img_params,
                PdfPage* page,
                PdfPageView* page_view,
-               int& image_index);
+               int& image_index,
+               ImageCache* image_cache);
 
-// Extracts all images from the document and saves them to save_path.
+// Extracts all images from the document and saves them to save_path. Images repeated on several
+// pages or in documents processed with the same image_cache are saved once, use a separate
+// save_path for each document sharing the cache.
 void ExtractImages(
     const std::wstring& open_path,                // source PDF document
     const std::wstring& save_path,                // directory where to extract images
     int render_width,                             // with of the rendered page in pixels (image )
-    PdfImageParams& img_params                    // image parameters
+    PdfImageParams& img_params,                   // image parameters
+    ImageCache* image_cache = nullptr             // cache of already extracted images
+    );
+
+// Extracts image XObjects without rasterizing pages. DCT and JPX streams are copied byte-for-byte,
+// other 8-bit gray and RGB images are decoded and saved as PNM. Masked and inline images are
+// rendered. Images shared by several pages, or by documents using the same image_cache, are
+// saved once.
+void ExtractImageStreams(
+    const std::wstring& open_path,                // source PDF document
+    const std::wstring& save_path,                // directory where to extract images
+    double render_zoom,                           // zoom used for rendering masked and inline images
+    size_t thread_count,                          // max number of threads
+    ImageCache* image_cache = nullptr             // cache of already extracted images
     );
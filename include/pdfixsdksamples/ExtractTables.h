@@ -1,21 +1,58 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
-// Example how to extract tables from a PDF document and save them to csv format.
-// GetText processes each element recursively. If the element is a text, saves it to the output stream.
-void GetText(PdeText* element, std::ofstream& ofs, bool eof);
+// Buffered CSV/TSV writer. Fields are quoted when they contain the delimiter, quotes or line
+// breaks and the buffer is passed to the output stream only when it's full or on Flush. Rows end
+// with line_end, "\r\n" for strict RFC 4180 output.
+class CsvWriter {
+  std::ostream& m_output;
+  char m_delimiter;
+  std::string m_line_end;
+  size_t m_capacity;
+  std::string m_buffer;
+  bool m_row_start = true;
 
-// SaveTable processes each element recursively.
-// If the element is a table, it saves it to save_path as csv.
-void SaveTable(PdeElement* element, std::wstring save_path, int& table_index);
+public:
+  CsvWriter(std::ostream& output, char delimiter = ',', const std::string& line_end = "\n",
+    size_t capacity = 1 << 16);
+  ~CsvWriter();
+  void WriteField(const std::wstring& field);
+  void WriteField(const std::string& field);
+  void EndRow();
+  void Flush();
+};
 
-// Extracts all tables from the document and saves them to CSV format.
+// table cells with spans expanded into a regular grid
+struct TableData {
+  int page_num = -1;                                  // page where the table was found
+  int table_index = 0;                                // index of the table in the document
+  std::vector<std::vector<std::wstring>> rows;        // cell texts
+};
+
+// Reads texts of all table cells. With expand_spans, a cell spanning several rows or columns is
+// repeated in each grid position it covers, otherwise the covered positions are left empty.
+void GetTableData(PdeTable* table, bool expand_spans, TableData& table_data);
+
+// Collects all tables on the page.
+void GetPageTables(PdfPage* page, bool expand_spans, std::vector<TableData>& tables);
+
+// Writes table rows, with_ids prefixes each row with the table index and the page number.
+void WriteTable(const TableData& table_data, CsvWriter& writer, bool with_ids);
+
+// Extracts all tables from the document and saves them to CSV format. Pages are processed in
+// parallel. With single_stream, all tables are written into one file with table and page ids,
+// otherwise each table gets its own file.
 void ExtractTables(
     const std::wstring& open_path,                 // source PDF document
-    const std::wstring& save_path                  // directory where to extract images
+    const std::wstring& save_path,                 // directory where to extract images
+    char delimiter = ',',                          // ',' for CSV, '\t' for TSV
+    bool single_stream = false,                    // write all tables into one file
+    bool expand_spans = false,                     // repeat spanned cells in all covered positions
+    size_t thread_count = 1                        // max number of threads
     );
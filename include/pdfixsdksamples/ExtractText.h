@@ -2,6 +2,8 @@
 
 #include <string>
 #include <iostream>
+#include <map>
+#include <mutex>
 
 #include "Pdfix.h"
 
@@ -9,10 +11,58 @@ using namespace PDFixSDK;
 
 namespace ExtractText {
   void GetPageText(PdfPage* page, std::stringstream &ss);
+
+  // Writes page texts to the output in page order while pages are extracted in parallel. Pages
+  // finished ahead of their turn wait in memory until all previous pages are written.
+  class OrderedPageWriter {
+    std::ostream& m_output;
+    std::string m_separator;
+    int m_flush_pages;
+    int m_next_page;
+    int m_written = 0;
+    std::map<int, std::string> m_pending;
+    std::mutex m_mutex;
+
+    void WritePage(int page_num, const std::string& text);
+
+  public:
+    OrderedPageWriter(std::ostream& output, int first_page, const std::string& separator, int flush_pages);
+    void Write(int page_num, std::string&& text);
+  };
+
+  // Extracts texts from the document page by page, each page is written to the output as soon as
+  // all previous pages are written.
   void Run(
-      const std::wstring& open_path,      // source PDF document
+      const std::wstring& open_path,       // source PDF document
       std::ostream& output,                // output stream
       const std::wstring& config_path,     // configuration file
-      const int page_number
+      const int page_number,               // page to process, -1 for all pages
+      const std::string& page_separator = "",  // text written between pages, {page} is the page number
+      int flush_pages = 0,                 // flush the output every flush_pages pages, 0 to not flush
+      size_t thread_count = 1              // max number of threads
+      );
+
+  // Appends text of the content objects in content stream order, form XObjects are entered
+  // recursively. With group_lines, text objects on the same baseline are joined into one line,
+  // otherwise each text object is written on its own line. No layout analysis is performed.
+  void GetContentText(PdsContent* content, bool group_lines, std::string& text);
+  void GetPageContentText(PdfPage* page, bool group_lines, std::string& text);
+
+  // Fast text extraction for indexing, pages are processed in parallel.
+  void RunFast(
+      const std::wstring& open_path,       // source PDF document
+      std::ostream& output,                // output stream
+      const int page_number,               // page to process, -1 for all pages
+      bool group_lines,                    // join text objects on the same line
+      const std::string& page_separator,   // text written between pages, {page} is the page number
+      int flush_pages,                     // flush the output every flush_pages pages, 0 to not flush
+      size_t thread_count                  // max number of threads
+      );
+
+  // Compares speed and output of the page map and the content stream extraction.
+  void Benchmark(
+      const std::wstring& open_path,       // source PDF document
+      std::ostream& output,                // report stream
+      size_t thread_count                  // max number of threads
       );
 }
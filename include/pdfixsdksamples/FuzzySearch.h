@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Pdfix.h"
+#include "PhraseSearch.h"
+
+using namespace PDFixSDK;
+
+// Approximate (edit-distance) search suitable for noisy OCR text layers.
+namespace FuzzySearch {
+
+  // approximate occurrence of the query on a page
+  struct Hit {
+    int page_num = -1;                    // page where the query was found
+    int distance = 0;                     // edit distance between the query and the matched text
+    double score = 0.;                    // 1 - distance / query length
+    std::wstring text;                    // matched text
+    std::vector<PdfQuad> quads;           // quads of all words the hit spans
+  };
+
+  // Finds all substrings of the text stream within max_distance edits of the query. Queries up
+  // to 64 characters use bit-parallel matching, longer queries fall back to dynamic programming.
+  void FindApproximate(
+    const PhraseSearch::TextStream& stream,   // normalized page text
+    const std::wstring& query,                // text to search
+    int max_distance,                         // max allowed number of edits
+    int page_num,                             // page number reported in hits
+    std::vector<Hit>& hits                    // found hits
+  );
+
+  // Searches all pages in parallel and writes hits ordered by score to the output stream.
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& query,            // text to search
+    int max_distance,                     // max allowed number of edits
+    std::ostream& output,                 // output stream
+    size_t thread_count                   // max number of threads
+  );
+}
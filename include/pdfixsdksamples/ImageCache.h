@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// text recognized in an image, coordinates are relative to the image bbox
+struct ImageText {
+  std::wstring text;
+  PdfRect rect;                       // text bbox, the image bbox maps to 0-1 on both axes
+};
+
+// Text is stored one item per line as "left bottom right top text", e.g. with page fingerprints.
+std::string WriteImageText(const std::vector<ImageText>& text);
+bool ReadImageText(const std::string& data, std::vector<ImageText>& text);
+
+// Fingerprint cache of images shared between pages and documents. Images are identified by their
+// XObject id within a document and by a hash of the image data across documents, so that repeated
+// logos or signatures are processed once and later occurrences refer to the first one.
+class ImageCache {
+  std::mutex m_mutex;
+  std::map<std::pair<PdfDoc*, int>, uint64_t> m_object_fingerprints;  // XObject id -> fingerprint
+  std::unordered_map<uint64_t, std::string> m_refs;                   // fingerprint -> first occurrence
+  std::unordered_map<uint64_t, std::vector<ImageText>> m_texts;       // fingerprint -> recognized text
+  size_t m_lookups = 0;
+  size_t m_hits = 0;
+
+  static uint64_t HashImageData(PdsStream* stream);
+  static uint64_t HashImageData(PdsStream* stream, const uint8_t* data, size_t size);
+
+public:
+  // Returns the fingerprint of the image, 0 if the image data can't be read.
+  uint64_t GetFingerprint(PdsImage* image);
+  // Same as above, the data already read from the image stream is hashed unless the XObject was
+  // hashed before.
+  uint64_t GetFingerprint(PdsImage* image, const uint8_t* data, size_t size);
+  // Fingerprint of an XObject hashed before, 0 if it's not known yet. Repeats of the XObject are
+  // found by its id without reading the data.
+  uint64_t FindFingerprint(PdsImage* image);
+  // Combined fingerprint of all image objects of a page map element, 0 if there's none or any
+  // of them can't be read.
+  uint64_t GetFingerprint(PdeElement* element);
+
+  // Looks up the fingerprint. Returns true if it was seen before and first_ref receives the
+  // reference of the first occurrence, otherwise the fingerprint is registered with ref.
+  bool Lookup(uint64_t fingerprint, const std::string& ref, std::string& first_ref);
+  bool Lookup(PdsImage* image, const std::string& ref, std::string& first_ref);
+  bool Lookup(PdeElement* element, const std::string& ref, std::string& first_ref);
+
+  // Stores text recognized at the first occurrence of the image.
+  void SetText(uint64_t fingerprint, std::vector<ImageText> text);
+  // Gets text of an already recognized image, returns false if the image wasn't recognized.
+  bool GetText(uint64_t fingerprint, std::vector<ImageText>& text);
+
+  // Forgets XObject ids of the document, call before the document is closed.
+  void ReleaseDocument(PdfDoc* doc);
+
+  size_t GetNumLookups();
+  size_t GetNumHits();
+  // ratio of all looked up images to unique images
+  double GetDedupeRatio();
+  void Report(std::ostream& output);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <iostream>
+#include <functional>
+#include <cstdint>
+#include <boost/property_tree/ptree.hpp>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+using namespace boost::property_tree;
+
+// Re-extracts only pages affected by incremental updates appended to the document since the
+// previous extraction. Results of other pages are taken from the cache of the previous run.
+namespace IncrementalExtraction {
+
+  // extraction result of one page together with the objects it depends on
+  struct PageEntry {
+    int page_id = 0;                      // object number of the page dictionary
+    std::vector<int> deps;                // indirect objects reachable from the page
+    ptree data;                           // extracted page data
+  };
+
+  struct Cache {
+    uint64_t file_size = 0;               // size of the document when it was extracted
+    uint64_t tail_hash = 0;               // hash of the bytes preceding file_size
+    uint64_t options = 0;                 // hash of the options the pages were extracted with
+    std::vector<PageEntry> pages;
+
+    bool Load(const std::wstring& path);
+    bool Save(const std::wstring& path) const;
+  };
+
+  // Hash of up to 4 KB of the file preceding size, used to check that the file was only appended to.
+  uint64_t GetTailHash(const std::wstring& path, uint64_t size);
+
+  // Collects object numbers of objects written after from_offset, including objects packed in
+  // object streams of the appended revisions.
+  void GetChangedObjects(PdfDoc* doc, const std::wstring& path, uint64_t from_offset,
+    std::set<int>& changed);
+
+  // Collects indirect objects the page content, resources and annotations refer to, ancestor page
+  // tree nodes and objects of the attributes the page inherits from them.
+  void GetPageDependencies(PdfPage* page, std::vector<int>& deps);
+
+  // Extracts pages changed since the cached extraction with extract_page and reuses cached data of
+  // the others. Cached data extracted with different options is not used. The cache is updated for
+  // the next run. Returns number of extracted pages.
+  int ExtractPages(
+    PdfDoc* doc,                                          // document to extract
+    const std::wstring& open_path,                        // path of the document
+    Cache& cache,                                         // previous extraction
+    uint64_t options,                                     // hash of the options of extract_page
+    const std::function<void(PdfPage*, ptree&)>& extract_page,  // page extraction
+    size_t thread_count                                   // max number of threads
+  );
+}
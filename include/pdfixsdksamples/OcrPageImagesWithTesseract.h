@@ -4,15 +4,39 @@
 #include <iostream>
 #include <vector>
 #include "Pdfix.h"
+#include "ImageCache.h"
+#include "EditContent.h"
+#include "PageFingerprint.h"
 
 using namespace PDFixSDK;
 
 void parse_page_element(PdeElement* elem, std::vector<PdfRect>& image_bbox_arr);
+
+// image of a page, repeated images reuse the text recognized at the first occurrence
+struct PageImage {
+    PdfRect bbox;
+    uint64_t fingerprint = 0;                       // image fingerprint, 0 if unknown
+    bool repeated = false;                          // image was seen before
+};
+void parse_page_images(PdeElement* elem, std::vector<PageImage>& images, ImageCache* image_cache,
+    int& duplicates);
+
+// Collects text objects added to the content from first_object on, relative to the image bbox.
+void CaptureOcrText(PdsContent* content, int first_object, const PdfRect& bbox,
+    std::vector<ImageText>& text);
+// Adds invisible text captured on another occurrence of the image, scaled to the bbox.
+void ReplayOcrText(EditContent::ResourceCache& cache, PdsContent* content,
+    const std::vector<ImageText>& text, const PdfRect& bbox);
+
+// OCRs images of all pages, images repeated across pages or documents sharing the image_cache are
+// OCRed only once and the recognized text is replayed at the other occurrences.
 void OcrPageImagesWithTesseract(
     const std::wstring& open_path,                  // source PDF document
     const std::wstring& save_path,                  // searchable PDF document
     const std::wstring& data_path,                  // path to OCR data
     const std::wstring& language,                   // default OCR language
     const double zoom,                              // zoom to control page rendering quality
-    const PdfRotate rotate                          // page rotation to be applied
+    const PdfRotate rotate,                         // page rotation to be applied
+    ImageCache* image_cache = nullptr,              // cache of already OCRed images
+    FingerprintStore* fingerprint_store = nullptr   // pages with known fingerprint reuse the stored text
     );
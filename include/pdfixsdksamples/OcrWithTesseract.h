@@ -3,6 +3,7 @@
 #include <string>
 #include <iostream>
 #include "Pdfix.h"
+#include "PageFingerprint.h"
 
 using namespace PDFixSDK;
 
@@ -12,5 +13,6 @@ void OcrWithTesseract(
     const std::wstring& data_path,                  // path to OCR data
     const std::wstring& language,                   // default OCR language
     const double zoom,                              // page zoom level for rendering to control image processing quality
-    const PdfRotate rotate                          // page rotation
+    const PdfRotate rotate,                         // page rotation
+    FingerprintStore* fingerprint_store = nullptr   // pages with known fingerprint reuse the stored text
     );
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <cstdint>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Fingerprint of the page computed from its decoded content streams, referenced resources,
+// annotations and page boxes. Pages with the same content get the same fingerprint even if the
+// files differ byte-wise (object numbers, compression, revision history).
+class PageHasher {
+  std::unordered_map<int, uint64_t> m_hashes;   // hashes of already visited indirect objects
+  std::unordered_set<int> m_visiting;           // indirect objects on the current path
+
+  uint64_t HashObject(PdsObject* object, uint64_t hash);
+
+public:
+  // Computes the fingerprint. Reuse the hasher for pages of the same document so that shared
+  // resources are hashed once, a hasher must not be used by several threads.
+  uint64_t GetFingerprint(PdfPage* page);
+};
+
+uint64_t GetPageFingerprint(PdfPage* page);
+
+// Results of already processed pages keyed by their fingerprint, can be saved and loaded between
+// runs. The result is whatever the sample needs to write the page output again without processing
+// the page, mix the processing options into the fingerprint when they change the result.
+class FingerprintStore {
+  std::mutex m_mutex;
+  std::unordered_map<uint64_t, std::string> m_results;
+  size_t m_checked = 0;
+  size_t m_skipped = 0;
+
+public:
+  bool Load(const std::wstring& path);
+  bool Save(const std::wstring& path);
+
+  // Returns true and the stored result if a page with the fingerprint was already processed and
+  // counts it as skipped.
+  bool Find(uint64_t fingerprint, std::string& result);
+  // Records the result of a processed page.
+  void Add(uint64_t fingerprint, const std::string& result);
+
+  size_t GetNumChecked();
+  size_t GetNumSkipped();
+  double GetSkipRate();
+  void Report(std::ostream& output);
+};
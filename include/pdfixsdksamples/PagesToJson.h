@@ -28,4 +28,15 @@ void Run(
     int export_flags,                                   // export flags
     int page_num                                        // page number to process
     );
+
+// Exports only pages changed by incremental updates since the previous run, other pages are
+// taken from the cache.
+void RunIncremental(
+    const std::wstring& open_path,                      // source PDF document
+    const std::wstring& password,                       // open password
+    const std::wstring& cache_path,                     // cache of the previous run, updated by the run
+    std::ostream& output,                               // output stream
+    int export_flags,                                   // export flags
+    size_t thread_count                                 // max number of threads
+    );
 }
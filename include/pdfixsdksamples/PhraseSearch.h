@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace PhraseSearch {
+
+  // Normalized text of a page built from its word list. Words are separated by a single space,
+  // line breaks are replaced by a space and words hyphenated across a line break are joined.
+  struct TextStream {
+    std::wstring text;                    // normalized text
+    std::wstring folded;                  // lower case copy of the text used for matching
+    std::vector<int> word_starts;         // offset of each word in the text
+    std::vector<PdfQuad> word_quads;      // quad of each word
+    std::vector<int> line_starts;         // index of the first word of each line
+  };
+
+  // phrase occurrence on a page
+  struct Hit {
+    int page_num = -1;                    // page where the phrase was found
+    int offset = 0;                       // offset of the hit in the text stream
+    int length = 0;                       // length of the hit in the text stream
+    std::wstring text;                    // matched text
+    std::vector<PdfQuad> quads;           // quads of all words the hit spans
+  };
+
+  // Collapses whitespace and removes soft hyphens. Lower cases the text when fold_case is set.
+  std::wstring NormalizeText(const std::wstring& text, bool fold_case);
+
+  // Builds the normalized text stream from the page word list.
+  void BuildTextStream(PdfPage* page, TextStream& stream);
+
+  // Collects quads of all words spanned by the text range [offset, offset + length).
+  void GetRangeQuads(const TextStream& stream, int offset, int length, std::vector<PdfQuad>& quads);
+
+  // Finds all occurrences of the phrase in the text stream. Matching is case insensitive.
+  void FindPhrase(const TextStream& stream, const std::wstring& phrase, int page_num,
+    std::vector<Hit>& hits);
+
+  // Searches the phrase on each page and writes the hits with their quads to the output stream.
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& phrase,           // phrase to search
+    std::ostream& output,                 // output stream
+    int page_num,                         // page to search, -1 for all pages
+    size_t thread_count                   // max number of threads
+  );
+}
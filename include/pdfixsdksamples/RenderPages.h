@@ -2,6 +2,7 @@
 
 #include <string>
 #include "Pdfix.h"
+#include "PageFingerprint.h"
 
 using namespace PDFixSDK;
 
@@ -14,5 +15,6 @@ void RenderPages(
     double zoom,                                // page zoom
     PdfRotate rotate,                           // page rotation
     PdfDevRect clip_rect,                       // clip region
-    size_t thread_count                         // max number of threads
+    size_t thread_count,                        // max number of threads
+    FingerprintStore* fingerprint_store = nullptr  // pages with known fingerprint copy the stored image
     );
@@ -3,10 +3,18 @@
 #include <string>
 
 namespace SearchText {
+  // how the found words are highlighted in the document
+  enum HighlightMode {
+    kHighlightPathPerHit = 0,       // separate path object for every hit
+    kHighlightPagePath = 1,         // single path object with all hits on the page
+    kHighlightAnnot = 2,            // single highlight annotation with all hits on the page
+  };
+
   void Run(
     const std::wstring& open_path,  // source PDF document
     const std::wstring& save_path,  // destynation PDF document
     const std::wstring& query,      // text to search in pdf file
-    int page_num = -1               // number of the page where to search, -1 for all pages
+    int page_num = -1,              // number of the page where to search, -1 for all pages
+    HighlightMode mode = kHighlightPathPerHit // highlight output mode
   );
 }
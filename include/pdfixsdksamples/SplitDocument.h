@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <iostream>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Splits one document into many by page ranges. The source is parsed once, outputs are
+// assembled from it and saved in parallel.
+namespace SplitDocument {
+
+  // output document with a range of source pages
+  struct Part {
+    int from = 0;                         // first page, 0-based
+    int to = 0;                           // last page, inclusive
+    std::wstring save_path;               // output PDF document
+  };
+
+  struct Stats {
+    size_t parts = 0;                     // number of written documents
+    size_t pages = 0;                     // number of written pages
+    size_t pruned = 0;                    // resource entries not referenced by page content
+    double seconds = 0.;                  // wall time of the split
+  };
+
+  // Parses a list of 1-based ranges like "1-10,11,12-" into parts saved as
+  // save_dir/part<index>.pdf. Throws on ranges outside of the document.
+  std::vector<Part> ParseRanges(const std::wstring& ranges, int num_pages, const std::wstring& save_dir);
+
+  // Collects names used as operands in the content stream data, inline image data is skipped.
+  void CollectNames(const uint8_t* data, size_t size, std::set<std::string>& names);
+
+  // Replaces resources of each page with a page-local dictionary holding only the entries its
+  // content refers to, so copying the page does not copy unused fonts, images and forms.
+  // Pages with unreadable content keep their resources. Only the document in memory is changed.
+  size_t PruneResources(PdfDoc* doc, size_t thread_count);
+
+  // Writes the parts of the document. Pages are copied one part at a time, the parts are saved
+  // in parallel.
+  void Split(
+    PdfDoc* doc,                          // source document
+    const std::vector<Part>& parts,       // page ranges and output paths
+    PdfSaveFlags save_flags,              // flags used to save every part
+    size_t thread_count,                  // max number of threads
+    Stats& stats                          // split statistics
+  );
+
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& ranges,           // 1-based page ranges separated by commas
+    const std::wstring& save_dir,         // output directory
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  );
+}
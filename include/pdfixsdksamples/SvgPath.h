@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// SVG path data parser (https://www.w3.org/TR/SVG11/paths.html#PathDataBNF).
+namespace SvgPath {
+
+  // receives segments of a parsed path in absolute coordinates
+  class PathSink {
+  public:
+    virtual ~PathSink() {}
+    virtual void MoveTo(const PdfPoint& pt) = 0;
+    virtual void LineTo(const PdfPoint& pt) = 0;
+    virtual void CurveTo(const PdfPoint& cp1, const PdfPoint& cp2, const PdfPoint& pt) = 0;
+    virtual void ArcTo(const PdfPoint& radius, double x_angle, bool large, bool sweep, const PdfPoint& pt) = 0;
+    virtual void ClosePath() = 0;
+  };
+
+  // emits the segments into a content path object
+  class PdsPathSink : public PathSink {
+    PdsPath* m_path;
+
+  public:
+    PdsPathSink(PdsPath* path) : m_path(path) {}
+    void MoveTo(const PdfPoint& pt) override;
+    void LineTo(const PdfPoint& pt) override;
+    void CurveTo(const PdfPoint& cp1, const PdfPoint& cp2, const PdfPoint& pt) override;
+    void ArcTo(const PdfPoint& radius, double x_angle, bool large, bool sweep, const PdfPoint& pt) override;
+    void ClosePath() override;
+  };
+
+  // Parses the full path grammar: absolute and relative M/L/H/V/C/S/Q/T/A/Z, implicit command
+  // repetition and packed numbers such as "M10-5l3.2.1". Quadratic segments are emitted as cubic
+  // curves. The parser does not allocate. As required by the SVG error handling rules, segments
+  // before a syntax error are emitted and false is returned.
+  bool Parse(const wchar_t* data, size_t length, PathSink& sink);
+
+  bool Parse(const std::wstring& data, PathSink& sink);
+
+  // Creates sample datasets: icons are short closed paths using every command, map paths are long
+  // packed relative polylines.
+  void CreateIconPaths(size_t count, std::vector<std::wstring>& paths);
+  void CreateMapPaths(size_t count, size_t segments, std::vector<std::wstring>& paths);
+
+  // Reads a dataset with one path data per line.
+  void LoadPaths(const std::wstring& path, std::vector<std::wstring>& paths);
+
+  // Measures the parser against the stream tokenizer used before on the same dataset.
+  void Benchmark(const std::string& name, const std::vector<std::wstring>& paths, std::ostream& output);
+
+  void Run(
+    const std::vector<std::wstring>& dataset_paths,  // datasets to benchmark, sample datasets if empty
+    std::ostream& output                             // output stream for the report
+  );
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include "Pdfix.h"
+#include "ContentOverlay.h"
+
+using namespace PDFixSDK;
+
+// Mass page creation from a template page. The template is imported once per document as a form
+// XObject, cloned pages share its content stream and resources and get only their variable text.
+namespace TemplatePages {
+
+  // variable text placed on a cloned page in Helvetica
+  struct Field {
+    PdfPoint pos;                         // baseline start in page coordinates
+    double font_size = 11;                // font size in points
+    std::wstring text;                    // text of the field
+  };
+
+  // fills the fields of the copy with the given index
+  using FieldsProc = std::function<void(size_t copy_index, std::vector<Field>& fields)>;
+
+  // Template page imported into one document.
+  class PageTemplate {
+    PdfDoc* m_doc;
+    PdfRect m_media_box;                  // crop box of the template page
+    PdsStream* m_content = nullptr;       // content drawing the template, shared by all clones
+    PdsDictionary* m_resources = nullptr; // resources of the shared content
+    PdsDictionary* m_font = nullptr;      // standard Helvetica font of the fields
+    ContentOverlay::OverlayWriter m_writer;
+
+  public:
+    // The template page may belong to another document, it is not referenced after the call.
+    PageTemplate(PdfDoc* doc, PdfPage* template_page);
+    PageTemplate(const PageTemplate&) = delete;
+    PageTemplate& operator=(const PageTemplate&) = delete;
+
+    // Appends a clone of the template page with the fields drawn over it.
+    void AddPage(const std::vector<Field>& fields);
+  };
+
+  struct Stats {
+    size_t documents = 0;                 // number of created documents
+    size_t pages = 0;                     // number of created pages
+    double seconds = 0.;                  // wall time of the creation
+    double GetPagesPerSecond() const { return seconds > 0 ? pages / seconds : 0.; }
+  };
+
+  // Creates documents of cloned pages in parallel, each worker opens the template document once.
+  // Documents are saved as save_dir/document<index>.pdf, or to a discarded memory stream when
+  // save_dir is empty.
+  void Generate(
+    const std::wstring& template_path,    // PDF document with the template page
+    int page_num,                         // template page number
+    const std::wstring& save_dir,         // output directory
+    size_t document_count,                // number of documents to create
+    size_t pages_per_document,            // number of cloned pages in each document
+    const FieldsProc& fill,               // fields of each copy
+    size_t thread_count,                  // max number of threads
+    Stats& stats                          // creation statistics
+  );
+
+  // Creates form letters addressed to numbered recipients.
+  void Run(
+    const std::wstring& template_path,    // PDF document with the letter design on the first page
+    const std::wstring& save_dir,         // output directory
+    size_t document_count,                // number of documents to create
+    size_t pages_per_document,            // number of letters in each document
+    size_t thread_count                   // max number of threads
+  );
+
+  // Measures pages/s and saved size of a document with page_count copies of a sample invoice,
+  // built from objects for each copy against cloned from a template page.
+  void Benchmark(
+    const std::wstring& logo_path,        // logo image placed on the invoice
+    size_t page_count,                    // number of copies
+    std::ostream& output                  // output stream for the report
+  );
+}
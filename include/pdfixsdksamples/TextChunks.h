@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Splits document text into size-bounded chunks with page, bbox and heading provenance for
+// retrieval and embedding pipelines. Chunks are emitted while later pages are still processed.
+namespace TextChunks {
+
+  enum BudgetUnit {
+    kBudgetCharacters = 0,                // chunk size measured in characters
+    kBudgetTokens = 1,                    // chunk size measured in whitespace separated words
+  };
+
+  // paragraph or heading of the page map
+  struct Block {
+    int page_num = -1;
+    PdfRect bbox;
+    int heading_level = 0;                // 1 for title and H1, 2 for H2, ..., 0 for body text
+    std::wstring text;
+  };
+
+  // part of the chunk located on one page
+  struct Region {
+    int page_num = -1;
+    PdfRect bbox;                         // union of bboxes of blocks contributing to the chunk
+  };
+
+  struct Chunk {
+    int index = 0;
+    std::wstring text;
+    std::vector<std::wstring> headings;   // enclosing headings, outermost first
+    std::vector<Region> regions;
+  };
+
+  // Collects text blocks of the page in reading order, page headers and footers are skipped.
+  void GetPageBlocks(PdfPage* page, std::vector<Block>& blocks);
+
+  // Builds chunks from blocks fed in document order. A chunk never spans a heading, blocks longer
+  // than the budget are split at word boundaries.
+  class Chunker {
+    size_t m_budget;
+    BudgetUnit m_unit;
+    std::function<void(const Chunk&)> m_emit;
+    std::vector<std::wstring> m_headings;
+    Chunk m_chunk;
+    size_t m_size = 0;
+    int m_next_index = 0;
+
+    static size_t Measure(const std::wstring& text, BudgetUnit unit);
+    void Append(const Block& block, const std::wstring& text, size_t size);
+
+  public:
+    Chunker(size_t budget, BudgetUnit unit, const std::function<void(const Chunk&)>& emit);
+    void Add(const Block& block);
+    // emits the pending chunk
+    void Flush();
+  };
+
+  // Writes the chunk as one line of JSON.
+  void WriteChunk(const Chunk& chunk, std::ostream& output);
+
+  // Processes pages in parallel with at most a few pages buffered ahead of the chunker and writes
+  // chunks as JSON lines.
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    std::ostream& output,                 // output stream
+    size_t budget,                        // max chunk size
+    BudgetUnit unit,                      // unit of the budget
+    size_t thread_count                   // max number of threads
+  );
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include "Pdfix.h"
+#include "EditContent.h"
+
+using namespace PDFixSDK;
+
+// Measures, breaks and flows paragraphs of generated text into columns of one or more pages.
+namespace TextLayout {
+
+  enum Alignment {
+    kAlignLeft = 0,
+    kAlignRight = 1,
+    kAlignCenter = 2,
+    kAlignJustify = 3,                    // last line of a paragraph is aligned left
+  };
+
+  struct TextStyle {
+    std::wstring font_name = L"Arial";
+    int font_flags = 0;                   // flags passed to FindSysFont
+    double font_size = 10;
+    double line_height = 1.2;             // distance of baselines relative to the font size
+    double paragraph_spacing = 6;         // extra space after a paragraph
+    Alignment alignment = kAlignLeft;
+    float color[3] = { 0, 0, 0 };         // DeviceRGB fill color
+  };
+
+  // Advance widths of glyphs of a system font, measured once per character on a private scratch
+  // document and cached. The widths do not depend on the document the text is placed in, one
+  // instance may serve any number of documents but must not be shared between threads.
+  class FontMetrics {
+    std::wstring m_font_name;
+    int m_font_flags = 0;
+    PdfDoc* m_doc = nullptr;
+    PdfPage* m_page = nullptr;            // scratch page kept alive for its content
+    PdsContent* m_content = nullptr;
+    PdfFont* m_font = nullptr;
+    double m_probe_width = 0;             // width of the characters around the measured one
+    std::vector<float> m_widths;          // width per 1pt font size by character code, < 0 if unknown
+
+    double MeasureText(const std::wstring& text);
+
+  public:
+    FontMetrics(Pdfix* pdfix, const std::wstring& font_name, int font_flags);
+    FontMetrics(const FontMetrics&) = delete;
+    FontMetrics& operator=(const FontMetrics&) = delete;
+    ~FontMetrics();
+
+    // true if the metrics measure the font of the style
+    bool IsFontOf(const TextStyle& style) const {
+      return style.font_name == m_font_name && style.font_flags == m_font_flags;
+    }
+
+    // width of the character at 1pt font size
+    double GetWidth(wchar_t ch) {
+      if ((size_t)(unsigned)ch < m_widths.size() && m_widths[ch] >= 0)
+        return m_widths[ch];
+      return Measure(ch);
+    }
+    double Measure(wchar_t ch);
+    double GetTextWidth(const wchar_t* text, size_t length, double font_size);
+  };
+
+  // line of a paragraph as a range of its characters
+  struct Line {
+    size_t begin = 0;
+    size_t end = 0;
+    double width = 0;                     // width without trailing spaces
+    int spaces = 0;                       // spaces stretched by justification
+    bool last = false;                    // last line of a paragraph or before a line feed
+  };
+
+  // Greedy line breaking at spaces and line feeds, words longer than the width are broken
+  // between characters.
+  void BreakLines(const wchar_t* text, size_t length, FontMetrics& metrics, double font_size,
+    double max_width, std::vector<Line>& lines);
+
+  // Splits the rect into columns separated by the gap.
+  void GetColumns(const PdfRect& rect, int columns, double gap, std::vector<PdfRect>& column_rects);
+
+  // Places paragraphs into frames in the order the frames were added, one PdsText per line.
+  // When the frames are full, the overflow callback may add more frames (e.g. on a new page).
+  class TextFlow {
+    struct Frame {
+      PdsContent* content;
+      PdfRect rect;
+    };
+
+    EditContent::ResourceCache& m_cache;
+    FontMetrics& m_metrics;
+    TextStyle m_style;
+    std::function<bool(TextFlow&)> m_overflow;
+    std::vector<Frame> m_frames;
+    size_t m_frame = 0;                   // frame receiving the next line
+    bool m_frame_started = false;         // a line was placed in the current frame
+    double m_baseline = 0;                // baseline of the last placed line
+    std::vector<Line> m_lines;            // reused between paragraphs
+    std::wstring m_line_text;
+    size_t m_line_count = 0;
+
+    bool NextBaseline(double& baseline);
+
+  public:
+    // The style must use the font measured by the metrics, otherwise runtime_error is thrown.
+    TextFlow(EditContent::ResourceCache& cache, FontMetrics& metrics, const TextStyle& style,
+      const std::function<bool(TextFlow&)>& overflow = nullptr);
+
+    void AddFrame(PdsContent* content, const PdfRect& rect);
+    // Changes size, spacing, alignment or color, the font can't change as lines are broken with
+    // the metrics of the flow.
+    void SetStyle(const TextStyle& style);
+
+    // Returns false if the paragraph did not fit, lines which fitted are placed.
+    bool AddParagraph(const std::wstring& text);
+    size_t GetNumLines() const { return m_line_count; }
+  };
+
+  // Creates sample paragraphs of pseudo-random words.
+  void CreateParagraphs(size_t count, std::vector<std::wstring>& paragraphs);
+
+  void Run(
+    const std::wstring& save_path,        // output PDF document
+    size_t paragraph_count,               // number of sample paragraphs
+    int columns,                          // number of columns on each page
+    Alignment alignment                   // alignment of the paragraphs
+  );
+
+  // Reports paragraphs/s of line breaking alone and of the complete layout with text objects.
+  void Benchmark(
+    size_t paragraph_count,               // number of sample paragraphs
+    std::ostream& output                  // output stream for the report
+  );
+}
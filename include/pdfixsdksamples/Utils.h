@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <functional>
+#include <cstdint>
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
@@ -10,10 +12,20 @@ using namespace PDFixSDK;
 bool DirectoryExists(const std::wstring& path, bool create);
 std::wstring FromUtf8(const std::string& str);
 std::string ToUtf8(const std::wstring& str);
+// appends UTF-8 encoded str to the output without creating a temporary string
+void AppendUtf8(const std::wstring& str, std::string& output);
 std::string PsStreamEncodeBase64(PsStream *stream);
 void PdfMatrixTransform(PdfMatrix &m, PdfPoint &p);
 void PdfMatrixConcat(PdfMatrix& m, PdfMatrix& m1, bool prepend);
 void PdfMatrixRotate(PdfMatrix& m, double radian, bool prepend);
 void PdfMatrixScale(PdfMatrix& m, double sx, double sy, bool prepend);
 void PdfMatrixTranslate(PdfMatrix& m, double x, double y, bool prepend);
-void PdfMatrixInverse(PdfMatrix& m, PdfMatrix& m1);
\ No newline at end of file
+void PdfMatrixInverse(PdfMatrix& m, PdfMatrix& m1);
+
+// FNV-1a hash of the data, pass the previous result as hash to continue hashing
+const uint64_t kHashSeed = 14695981039346656037ull;
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash = kHashSeed);
+
+// Splits the range [from, to] into contiguous chunks and processes each chunk in its own thread.
+// The first exception thrown by a worker is rethrown once all workers have finished.
+void ParallelFor(int from, int to, size_t thread_count, const std::function<void(int, int)>& process);
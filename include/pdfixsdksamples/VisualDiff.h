@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Compares rendered pages of two revisions of a document and reports changed regions.
+namespace VisualDiff {
+
+  enum PageStatus {
+    kPageIdentical = 0,                   // same fingerprint, not rendered
+    kPageUnchanged = 1,                   // rendered pages are equal within the tolerance
+    kPageChanged = 2,
+    kPageAdded = 3,                       // page exists only in the new document
+    kPageRemoved = 4,                     // page exists only in the old document
+  };
+
+  struct PageDiff {
+    int page_num = -1;
+    PageStatus status = kPageIdentical;
+    int changed_pixels = 0;
+    std::vector<PdfRect> regions;         // changed regions in page coordinates
+  };
+
+  // Counts pixels of two 32-bit bitmaps of the same size which differ in any channel by more than
+  // tolerance. tile_counts receives number of changed pixels in each tile_size x tile_size tile.
+  int DiffPixels(const uint8_t* old_pixels, const uint8_t* new_pixels, int width, int height,
+    int tolerance, int tile_size, std::vector<int>& tile_counts);
+
+  // Joins adjacent changed tiles into bounding boxes in device coordinates.
+  void GetChangedRegions(const std::vector<int>& tile_counts, int width, int height, int tile_size,
+    std::vector<PdfDevRect>& regions);
+
+  // Compares corresponding pages, pages with equal fingerprints are not rendered. When overlay_dir
+  // is not empty, changed pages of the new document are saved there with changes highlighted.
+  void ComparePages(PdfDoc* old_doc, PdfDoc* new_doc, double zoom, int tolerance,
+    const std::wstring& overlay_dir, size_t thread_count, std::vector<PageDiff>& diffs);
+
+  void Run(
+    const std::wstring& old_path,         // original PDF document
+    const std::wstring& new_path,         // revised PDF document
+    double zoom,                          // rendering zoom
+    int tolerance,                        // max channel difference of equal pixels
+    const std::wstring& overlay_dir,      // directory for overlay images, empty for none
+    std::ostream& output,                 // output stream for the JSON report
+    size_t thread_count                   // max number of threads
+  );
+}
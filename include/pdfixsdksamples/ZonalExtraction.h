@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <boost/property_tree/ptree.hpp>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+using namespace boost::property_tree;
+
+// Extracts text from fixed named regions of same-layout documents (invoices, statements).
+namespace ZonalExtraction {
+
+  // named region of a page template
+  struct Zone {
+    std::string name;                     // name of the zone in the output
+    int page_num = -1;                    // page of the zone, -1 for every page
+    PdfRect rect;                         // zone rectangle in page coordinates
+  };
+
+  // uniform grid over the page used to find words inside a rectangle
+  class WordIndex {
+    PdfRect m_bounds;
+    double m_cell_size;
+    int m_cols = 0;
+    int m_rows = 0;
+    std::vector<std::vector<int>> m_cells;  // word indexes in each cell
+    std::vector<PdfRect> m_bboxes;          // bbox of each word
+
+    void GetCellRange(const PdfRect& rect, int& col_from, int& row_from, int& col_to, int& row_to) const;
+
+  public:
+    WordIndex(const PdfRect& bounds, double cell_size);
+    void Add(const PdfRect& bbox);
+    // collects indexes of words which center lies inside the rect, in the order they were added
+    void Query(const PdfRect& rect, std::vector<int>& words) const;
+  };
+
+  // Extracts text of all zones defined for the page into the node.
+  void ExtractPageZones(PdfPage* page, const std::vector<Zone>& zones, ptree& node);
+
+  // Extracts zones of a single document.
+  void ExtractDocumentZones(PdfDoc* doc, const std::vector<Zone>& zones, ptree& node);
+
+  void Run(
+    const std::vector<std::wstring>& open_paths,   // source PDF documents with the same layout
+    const std::vector<Zone>& zones,                // zones of the page template
+    std::ostream& output,                          // output stream
+    size_t thread_count                            // max number of threads
+  );
+}
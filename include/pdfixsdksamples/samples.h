@@ -3,10 +3,20 @@
 #include "AddComment.h"
 #include "AddTags.h"
 #include "AddWatermark.h"
+#include "BatchRedaction.h"
 #include "BookmarksToJson.h"
 #include "ConvertRGBToCMYK.h"
 #include "ConvertToHtml.h"
 #include "ConvertToHtmlEx.h"
+#include "ConvertToMarkdown.h"
+#include "DocumentGenerator.h"
+#include "SvgPath.h"
+#include "TextLayout.h"
+#include "ContentOverlay.h"
+#include "BatchStamping.h"
+#include "ConvertImageColors.h"
+#include "TemplatePages.h"
+#include "SplitDocument.h"
 #include "DigitalSignature.h"
 #include "DocumentMetadata.h"
 #include "DocumentSecurity.h"
@@ -18,6 +28,7 @@
 #include "ExtractHighlightedText.h"
 #include "ExtractImages.h"
 #include "ExtractTables.h"
+#include "FuzzySearch.h"
 #include "FillForm.h"
 #include "FlattenAnnots.h"
 #include "GetWhitespace.h"
@@ -28,6 +39,7 @@
 #include "OpedDocumentFromStream.h"
 #include "ParsePageContent.h"
 #include "ParsePdsObjects.h"
+#include "PhraseSearch.h"
 #include "PrintPage.h"
 #include "ProcessControl.h"
 #include "RegexSearch.h"
@@ -36,5 +48,8 @@
 #include "RemoveComments.h"
 #include "RenderPage.h"
 #include "SearchText.h"
+#include "TextChunks.h"
+#include "VisualDiff.h"
 #include "SetFieldFlags.h"
 #include "SetFormFieldValue.h"
+#include "ZonalExtraction.h"
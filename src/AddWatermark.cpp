@@ -5,6 +5,7 @@
 
 #include "pdfixsdksamples/AddWatermark.h"
 #include "pdfixsdksamples/Utils.h"
+#include "pdfixsdksamples/ContentOverlay.h"
 #include <string>
 #include <iostream>
 #include "Pdfix.h"
@@ -26,7 +27,8 @@ void AddWatermark(
   float v_value,                                    // the vertical offset value to be used when adding the watermark on a page
   float scale,                                      // the scale factor to be used when adding the watermark, with 1.0 meaning 100%
   float rotation,                                   // the counter-clockwise rotation, in degrees, to be used when adding the watermark
-  float opacity                                     // the opacity to be used when adding the watermark
+  float opacity,                                    // the opacity to be used when adding the watermark
+  bool append_only                                  // add the watermark as a separate content stream instead of SetContent
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -60,15 +62,14 @@ void AddWatermark(
   if (start_page>=page_num || end_page<start_page)
     throw std::runtime_error("Page number out of range");
 
+  ContentOverlay::OverlayWriter overlay_writer(doc);
+  std::string overlay_operators;
+
   for (int i=start_page; i<=end_page; i++) {
     auto page = doc->AcquirePage(i);
     if (!page)
       throw PdfixException();
 
-    auto content = page->GetContent();
-    if (!content)
-      throw PdfixException();
-
     auto xobjdict = image_obj->GetStreamDict();
     auto width = xobjdict->GetNumber(L"Width");
     auto height = xobjdict->GetNumber(L"Height");
@@ -118,6 +119,20 @@ void AddWatermark(
     //-offs_v because y coordinate from top to bottom
     PdfMatrixTranslate(matrix, offs_h, -offs_v, false);
 
+    if (append_only) {
+      // the page content is not parsed, the watermark goes to its own content stream
+      overlay_operators.clear();
+      overlay_writer.DrawXObject(page, image_obj, matrix, opacity, overlay_operators);
+      overlay_writer.Write(page, overlay_operators,
+        order_top == 1 ? ContentOverlay::kLayerOverlay : ContentOverlay::kLayerUnderlay);
+      page->Release();
+      continue;
+    }
+
+    auto content = page->GetContent();
+    if (!content)
+      throw PdfixException();
+
     auto position = order_top == 1 ? -1 : 0;
     auto imageobject = content->AddNewImage(position, image_obj, &matrix);
 
@@ -0,0 +1,237 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// BatchRedaction.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/BatchRedaction.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include "pdfixsdksamples/PhraseSearch.h"
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace BatchRedaction {
+
+  static void AddMatch(const PhraseSearch::TextStream& stream, int page_num, int from, int length,
+    std::vector<Match>& matches) {
+    if (length <= 0)
+      return;
+    Match match;
+    match.page_num = page_num;
+    match.text = stream.text.substr(from, length);
+    PhraseSearch::GetRangeQuads(stream, from, length, match.quads);
+    matches.push_back(match);
+  }
+
+  static void FindText(const PhraseSearch::TextStream& stream, int page_num,
+    const std::wstring& pattern, std::vector<Match>& matches) {
+    std::vector<PhraseSearch::Hit> hits;
+    PhraseSearch::FindPhrase(stream, pattern, page_num, hits);
+    for (auto& hit : hits)
+      AddMatch(stream, page_num, hit.offset, hit.length, matches);
+  }
+
+  static void FindRegex(const PhraseSearch::TextStream& stream, int page_num, PsRegex* regex,
+    std::vector<Match>& matches) {
+    auto& text = stream.text;
+    int start_pos = 0;
+    while (start_pos < (int)text.length()) {
+      if (!regex->Search(text.c_str(), start_pos))
+        break;
+      int pos = regex->GetPosition();
+      int len = regex->GetLength();
+      AddMatch(stream, page_num, start_pos + pos, len, matches);
+      start_pos += pos + std::max(len, 1);
+    }
+  }
+
+  void FindMatches(
+    PdfDoc* doc,                                    // document to search
+    const std::vector<std::wstring>& patterns,      // list of patterns to search
+    bool use_regex,                                 // patterns are regular expressions
+    size_t thread_count,                            // max number of threads
+    std::vector<std::vector<Match>>& page_matches   // found matches per page
+  ) {
+    auto num_pages = doc->GetNumPages();
+    page_matches.clear();
+    page_matches.resize(num_pages);
+
+    auto find_matches = [&](int from, int to) {
+      // each worker uses its own regex objects
+      auto regex_deleter = [](PsRegex* regex) { regex->Destroy(); };
+      std::vector<std::unique_ptr<PsRegex, decltype(regex_deleter)>> regexes;
+      if (use_regex) {
+        for (auto& pattern : patterns) {
+          regexes.emplace_back(GetPdfix()->CreateRegex(), regex_deleter);
+          if (!regexes.back())
+            throw PdfixException();
+          if (!regexes.back()->SetPattern(pattern.c_str()))
+            throw PdfixException();
+        }
+      }
+
+      for (int i = from; i <= to; i++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+
+        PhraseSearch::TextStream stream;
+        PhraseSearch::BuildTextStream(page.get(), stream);
+
+        auto& matches = page_matches[i];
+        if (use_regex) {
+          for (auto& regex : regexes)
+            FindRegex(stream, i, regex.get(), matches);
+        }
+        else {
+          for (auto& pattern : patterns) {
+            FindText(stream, i, pattern, matches);
+          }
+        }
+      }
+    };
+
+    ParallelFor(0, num_pages - 1, thread_count, find_matches);
+  }
+
+  void CreateRedactionAnnot(PdfPage* page, const Match& match) {
+    if (match.quads.empty())
+      return;
+
+    // annotation rect is the bounding box of all quads
+    PdfRect rect = { };
+    bool first = true;
+    for (auto& quad : match.quads) {
+      for (auto& pt : { quad.tl, quad.tr, quad.bl, quad.br }) {
+        if (first) {
+          rect.left = rect.right = pt.x;
+          rect.bottom = rect.top = pt.y;
+          first = false;
+        }
+        rect.left = std::min(rect.left, pt.x);
+        rect.right = std::max(rect.right, pt.x);
+        rect.bottom = std::min(rect.bottom, pt.y);
+        rect.top = std::max(rect.top, pt.y);
+      }
+    }
+
+    auto redact_annot = page->AddNewAnnot(-1, &rect, kAnnotRedact);
+    if (!redact_annot)
+      throw PdfixException();
+
+    redact_annot->NotifyWillChange(L"QuadPoints");
+
+    auto redact_dict = redact_annot->GetObject();
+
+    // quad points in the order x1 y1 (top-left), x2 y2 (top-right), x3 y3 (bottom-left), x4 y4 (bottom-right)
+    auto quad_points = redact_dict->PutArray(L"QuadPoints");
+    int index = 0;
+    for (auto& quad : match.quads) {
+      for (auto& pt : { quad.tl, quad.tr, quad.bl, quad.br }) {
+        quad_points->PutNumber(index++, pt.x);
+        quad_points->PutNumber(index++, pt.y);
+      }
+    }
+
+    // Outline color (red)
+    auto outline_color = redact_dict->PutArray(L"OC");
+    outline_color->PutNumber(0, 1.0);
+    outline_color->PutNumber(1, 0.0);
+    outline_color->PutNumber(2, 0.0);
+
+    // Inner color (black)
+    auto inner_color = redact_dict->PutArray(L"IC");
+    inner_color->PutNumber(0, 0.0);
+    inner_color->PutNumber(1, 0.0);
+    inner_color->PutNumber(2, 0.0);
+
+    // Notify after editing - this will regenerate redaction appearance from given settings
+    redact_annot->NotifyDidChange(L"QuadPoints", 0);
+  }
+
+  void Run(
+    const std::wstring& open_path,                  // source PDF document
+    const std::wstring& save_path,                  // redacted PDF document
+    const std::vector<std::wstring>& patterns,      // list of patterns to redact
+    bool use_regex,                                 // patterns are regular expressions
+    size_t thread_count,                            // max number of threads
+    std::ostream& report                            // output stream for the processing report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    auto num_pages = doc->GetNumPages();
+    auto clock_start = std::chrono::steady_clock::now();
+    auto report_stage = [&](const char* stage, size_t count, const char* unit) {
+      auto now = std::chrono::steady_clock::now();
+      double seconds = std::chrono::duration<double>(now - clock_start).count();
+      report << stage << ": " << count << " " << unit << " in " << seconds << " s";
+      if (seconds > 0)
+        report << " (" << count / seconds << " " << unit << "/s)";
+      report << std::endl;
+      clock_start = now;
+    };
+
+    // stage 1: search all pages in parallel
+    std::vector<std::vector<Match>> page_matches;
+    FindMatches(doc, patterns, use_regex, thread_count, page_matches);
+    report_stage("search", num_pages, "pages");
+
+    // stage 2: create redaction annotations from match quads
+    size_t match_count = 0;
+    for (int i = 0; i < num_pages; i++) {
+      if (page_matches[i].empty())
+        continue;
+      PdfPage* page = doc->AcquirePage(i);
+      if (!page)
+        throw PdfixException();
+      for (auto& match : page_matches[i])
+        CreateRedactionAnnot(page, match);
+      match_count += page_matches[i].size();
+      page->Release();
+    }
+    report_stage("mark", match_count, "matches");
+
+    // stage 3: apply redaction and save the document
+    if (!doc->ApplyRedaction(nullptr, nullptr))
+      throw PdfixException();
+    if (!doc->Save(save_path.c_str(), kSaveFull))
+      throw PdfixException();
+    doc->Close();
+    report_stage("apply", num_pages, "pages");
+
+    // stage 4: verify that no matched text remains in the redacted document
+    PdfDoc* redacted_doc = pdfix->OpenDoc(save_path.c_str(), L"");
+    if (!redacted_doc)
+      throw PdfixException();
+    FindMatches(redacted_doc, patterns, use_regex, thread_count, page_matches);
+    redacted_doc->Close();
+    report_stage("verify", num_pages, "pages");
+
+    size_t remaining = 0;
+    for (auto& matches : page_matches)
+      remaining += matches.size();
+    report << "redacted: " << match_count << ", remaining: " << remaining << std::endl;
+
+    pdfix->Destroy();
+
+    if (remaining > 0)
+      throw std::runtime_error("Redacted document still contains matched text");
+  }
+} // namespace BatchRedaction
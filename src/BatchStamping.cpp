@@ -0,0 +1,407 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// BatchStamping.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/BatchStamping.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <ctime>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace BatchStamping {
+
+  void StampAsset::Create(Pdfix* pdfix, const std::wstring& image_path) {
+    auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+    std::unique_ptr<PdfDoc, decltype(doc_deleter)> doc(pdfix->CreateDoc(), doc_deleter);
+    if (!doc)
+      throw PdfixException();
+
+    auto image_stm = pdfix->CreateFileStream(image_path.c_str(), kPsReadOnly);
+    if (!image_stm)
+      throw PdfixException();
+    PdfImageFormat format = kImageFormatJpg;
+    if ((image_path.rfind(L".png") != std::wstring::npos)
+      || (image_path.rfind(L".PNG") != std::wstring::npos))
+      format = kImageFormatPng;
+    auto xobj = doc->CreateXObjectFromImage(image_stm, format);
+    image_stm->Destroy();
+    if (!xobj)
+      throw PdfixException();
+
+    auto image_dict = xobj->GetStreamDict();
+    m_width = image_dict->GetNumber(L"Width");
+    m_height = image_dict->GetNumber(L"Height");
+
+    // the page has the size of the image, the image fills it
+    PdfRect media_box;
+    media_box.right = m_width;
+    media_box.top = m_height;
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->CreatePage(-1, &media_box), page_deleter);
+    if (!page)
+      throw PdfixException();
+    PdfMatrix matrix;
+    matrix.a = m_width;
+    matrix.d = m_height;
+    if (!page->GetContent()->AddNewImage(-1, xobj, &matrix))
+      throw PdfixException();
+    if (!page->SetContent())
+      throw PdfixException();
+    page.reset();
+
+    auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+    std::unique_ptr<PsStream, decltype(stm_deleter)> stm(pdfix->CreateMemStream(), stm_deleter);
+    if (!stm)
+      throw PdfixException();
+    if (!doc->SaveToStream(stm.get(), kSaveFull))
+      throw PdfixException();
+    m_data.resize(stm->GetSize());
+    if (!m_data.empty() && !stm->Read(0, m_data.data(), (int)m_data.size()))
+      throw PdfixException();
+  }
+
+  PdfDoc* StampAsset::Open(Pdfix* pdfix, PsStream* stream) const {
+    if (!stream->Write(0, m_data.data(), (int)m_data.size()))
+      throw PdfixException();
+    auto doc = pdfix->OpenDocFromStream(stream, L"");
+    if (!doc)
+      throw PdfixException();
+    return doc;
+  }
+
+  std::wstring ExpandFields(const std::wstring& text, const std::map<std::wstring, std::wstring>& fields) {
+    std::wstring result;
+    result.reserve(text.length());
+    size_t pos = 0;
+    while (pos < text.length()) {
+      auto open = text.find(L'{', pos);
+      auto close = open == std::wstring::npos ? open : text.find(L'}', open);
+      if (close == std::wstring::npos) {
+        result.append(text, pos, std::wstring::npos);
+        break;
+      }
+      result.append(text, pos, open - pos);
+      auto found = fields.find(text.substr(open + 1, close - open - 1));
+      if (found != fields.end())
+        result += found->second;
+      else
+        result.append(text, open, close - open + 1);
+      pos = close + 1;
+    }
+    return result;
+  }
+
+  std::wstring FormatBates(const Job& job, int page_num) {
+    std::wstringstream ss;
+    ss << job.bates_prefix << std::setw(job.bates_digits) << std::setfill(L'0')
+      << job.first_bates + page_num;
+    return ss.str();
+  }
+
+  std::string EncodeWinAnsi(const std::wstring& text) {
+    static const wchar_t specials[32] = {
+      0x20AC, 0, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039,
+      0x0152, 0, 0x017D, 0, 0, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+      0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0, 0x017E, 0x0178 };
+    std::string result;
+    result.reserve(text.length());
+    for (auto ch : text) {
+      if ((ch >= 0x20 && ch < 0x80) || (ch >= 0xA0 && ch <= 0xFF)) {
+        result += (char)ch;
+        continue;
+      }
+      char code = '?';
+      for (int i = 0; i < 32; i++) {
+        if (specials[i] && specials[i] == ch)
+          code = (char)(0x80 + i);
+      }
+      result += code;
+    }
+    return result;
+  }
+
+  double GetHelveticaWidth(const std::string& text) {
+    // advance widths of the standard Helvetica font for codes 32-126 in 1/1000 em
+    static const short widths[95] = {
+      278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,
+      556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556,
+      1015, 667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833, 722, 778,
+      667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 278, 278, 278, 469, 556,
+      333, 556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,
+      556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584 };
+    double width = 0;
+    for (auto ch : text) {
+      auto code = (unsigned char)ch;
+      width += code >= 32 && code <= 126 ? widths[code - 32] : 556;
+    }
+    return width / 1000.;
+  }
+
+  // position of a stamp of the given size inside the crop box
+  static PdfPoint PlaceStamp(const PdfRect& crop_box, const StampParams& params, double width,
+    double height) {
+    PdfPoint pos;
+    if (params.h_align == kAlignmentLeft)
+      pos.x = crop_box.left + params.margin;
+    else if (params.h_align == kAlignmentCenter)
+      pos.x = (crop_box.left + crop_box.right - width) / 2;
+    else
+      pos.x = crop_box.right - params.margin - width;
+
+    if (params.v_align == kAlignmentTop)
+      pos.y = crop_box.top - params.margin - height;
+    else if (params.v_align == kAlignmentCenter)
+      pos.y = (crop_box.bottom + crop_box.top - height) / 2;
+    else
+      pos.y = crop_box.bottom + params.margin;
+    return pos;
+  }
+
+  void StampDocument(
+    PdfDoc* doc,                          // document to stamp
+    const Job& job,                       // job of the document
+    const StampParams& params,            // stamp settings
+    PdfPage* asset_page,                  // page of the opened stamp asset, nullptr for no image
+    const std::wstring& date              // value of the {date} field
+  ) {
+    auto num_pages = doc->GetNumPages();
+
+    PdsStream* xobj = nullptr;
+    PdfRect asset_box;
+    if (asset_page) {
+      xobj = doc->CreateXObjectFromPage(asset_page);
+      if (!xobj)
+        throw PdfixException();
+      asset_box = asset_page->GetCropBox();
+    }
+
+    // standard font, nothing is embedded
+    PdsDictionary* font = nullptr;
+    std::map<std::wstring, std::wstring> fields;
+    if (!params.text.empty()) {
+      font = doc->CreateDictObject(true);
+      if (!font)
+        throw PdfixException();
+      font->PutName(L"Type", L"Font");
+      font->PutName(L"Subtype", L"Type1");
+      font->PutName(L"BaseFont", L"Helvetica");
+      font->PutName(L"Encoding", L"WinAnsiEncoding");
+
+      fields = job.fields;
+      fields[L"pages"] = std::to_wstring(num_pages);
+      fields[L"date"] = date;
+      fields[L"file"] = job.open_path.substr(job.open_path.find_last_of(L"/\\") + 1);
+    }
+
+    ContentOverlay::OverlayWriter writer(doc);
+    std::string operators;
+    for (int i = 0; i < num_pages; i++) {
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+      auto crop_box = page->GetCropBox();
+      operators.clear();
+
+      // the text is placed at the edge, the image next to it
+      double text_height = 0;
+      if (font) {
+        fields[L"page"] = std::to_wstring(i + 1);
+        fields[L"bates"] = FormatBates(job, i);
+        auto text = EncodeWinAnsi(ExpandFields(params.text, fields));
+        // baseline is placed at the bottom of the stamp, descenders reach into the margin
+        auto pos = PlaceStamp(crop_box, params, GetHelveticaWidth(text) * params.font_size, params.font_size);
+        writer.DrawText(page.get(), font, params.font_size, pos, text, params.opacity, operators);
+        text_height = params.font_size * 1.5;
+      }
+
+      if (xobj) {
+        double width = (asset_box.right - asset_box.left) * params.image_scale;
+        double height = (asset_box.top - asset_box.bottom) * params.image_scale;
+        auto pos = PlaceStamp(crop_box, params, width, height);
+        if (params.v_align == kAlignmentTop)
+          pos.y -= text_height;
+        else if (params.v_align != kAlignmentCenter)
+          pos.y += text_height;
+        PdfMatrix matrix;
+        matrix.a = params.image_scale;
+        matrix.d = params.image_scale;
+        matrix.e = pos.x - asset_box.left * params.image_scale;
+        matrix.f = pos.y - asset_box.bottom * params.image_scale;
+        writer.DrawXObject(page.get(), xobj, matrix, params.opacity, operators);
+      }
+
+      if (!operators.empty())
+        writer.Write(page.get(), operators, params.layer);
+    }
+  }
+
+  long long AssignBatesNumbers(
+    Pdfix* pdfix,                         // pdfix instance
+    std::vector<Job>& jobs,               // documents of the production
+    long long first_number,               // Bates number of the first page of the first job
+    size_t thread_count                   // max number of threads
+  ) {
+    std::vector<int> page_counts(jobs.size());
+    auto count_pages = [&](int from, int to) {
+      for (int i = from; i <= to; i++) {
+        auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+        std::unique_ptr<PdfDoc, decltype(doc_deleter)>
+          doc(pdfix->OpenDoc(jobs[i].open_path.c_str(), L""), doc_deleter);
+        if (!doc)
+          throw PdfixException();
+        page_counts[i] = doc->GetNumPages();
+      }
+    };
+    ParallelFor(0, (int)jobs.size() - 1, thread_count, count_pages);
+
+    // exclusive prefix sum of the page counts
+    long long number = first_number;
+    for (size_t i = 0; i < jobs.size(); i++) {
+      jobs[i].first_bates = number;
+      number += page_counts[i];
+    }
+    return number - first_number;
+  }
+
+  void SetBatesPageLabels(PdfDoc* doc, const Job& job) {
+    auto label = doc->CreateDictObject(false);
+    if (!label)
+      throw PdfixException();
+    if (!label->PutName(L"S", L"D") || !label->PutNumber(L"St", (double)job.first_bates))
+      throw PdfixException();
+    if (!job.bates_prefix.empty() && !label->PutString(L"P", job.bates_prefix.c_str()))
+      throw PdfixException();
+
+    auto page_labels = doc->GetRootObject()->PutDict(L"PageLabels");
+    if (!page_labels)
+      throw PdfixException();
+    auto nums = page_labels->PutArray(L"Nums");
+    if (!nums)
+      throw PdfixException();
+    // the new array is empty, entries are inserted
+    if (!nums->InsertNumber(0, 0) || !nums->Insert(1, label))
+      throw PdfixException();
+  }
+
+  static void StampJobs(Pdfix* pdfix, const std::vector<Job>& jobs, const StampParams& params,
+    size_t thread_count, std::ostream& output) {
+    auto clock_start = std::chrono::steady_clock::now();
+
+    // the image is decoded and compressed only here
+    StampAsset asset;
+    if (!params.image_path.empty())
+      asset.Create(pdfix, params.image_path);
+
+    std::wstring date;
+    {
+      auto now = std::time(nullptr);
+      wchar_t buffer[16];
+      std::wcsftime(buffer, 16, L"%Y-%m-%d", std::localtime(&now));
+      date = buffer;
+    }
+
+    std::atomic<size_t> page_count(0);
+    auto stamp_docs = [&](int from, int to) {
+      // each worker opens its own copy of the asset
+      auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+      std::unique_ptr<PsStream, decltype(stm_deleter)> asset_stm(nullptr, stm_deleter);
+      auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+      std::unique_ptr<PdfDoc, decltype(doc_deleter)> asset_doc(nullptr, doc_deleter);
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> asset_page(nullptr, page_deleter);
+      if (!asset.IsEmpty()) {
+        asset_stm.reset(pdfix->CreateMemStream());
+        if (!asset_stm)
+          throw PdfixException();
+        asset_doc.reset(asset.Open(pdfix, asset_stm.get()));
+        asset_page.reset(asset_doc->AcquirePage(0));
+        if (!asset_page)
+          throw PdfixException();
+      }
+
+      for (int i = from; i <= to; i++) {
+        auto& job = jobs[i];
+        std::unique_ptr<PdfDoc, decltype(doc_deleter)>
+          doc(pdfix->OpenDoc(job.open_path.c_str(), L""), doc_deleter);
+        if (!doc)
+          throw PdfixException();
+        StampDocument(doc.get(), job, params, asset_page.get(), date);
+        if (params.bates_page_labels)
+          SetBatesPageLabels(doc.get(), job);
+        if (!doc->Save(job.save_path.c_str(), kSaveFull))
+          throw PdfixException();
+        page_count += doc->GetNumPages();
+      }
+    };
+    ParallelFor(0, (int)jobs.size() - 1, thread_count, stamp_docs);
+
+    auto clock_end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+    output << "stamped " << jobs.size() << " documents, " << page_count << " pages in " << seconds << " s";
+    if (seconds > 0)
+      output << " (" << jobs.size() / seconds << " docs/s)";
+    output << std::endl;
+  }
+
+  void Run(
+    const std::vector<Job>& jobs,         // documents to stamp
+    const StampParams& params,            // stamp settings
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    StampJobs(pdfix, jobs, params, thread_count, output);
+
+    pdfix->Destroy();
+  }
+
+  void RunProduction(
+    std::vector<Job> jobs,                // documents of the production in numbering order
+    long long first_number,               // Bates number of the first page
+    const StampParams& params,            // stamp settings, text usually contains {bates}
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    auto clock_start = std::chrono::steady_clock::now();
+    auto page_count = AssignBatesNumbers(pdfix, jobs, first_number, thread_count);
+    auto clock_end = std::chrono::steady_clock::now();
+    output << "numbered " << page_count << " pages of " << jobs.size() << " documents in "
+      << std::chrono::duration<double>(clock_end - clock_start).count() << " s";
+    if (page_count > 0) {
+      auto& last = jobs.back();
+      auto last_page = (int)(first_number + page_count - 1 - last.first_bates);
+      output << ", last Bates number " << ToUtf8(FormatBates(last, last_page));
+    }
+    output << std::endl;
+
+    StampJobs(pdfix, jobs, params, thread_count, output);
+
+    pdfix->Destroy();
+  }
+} // namespace BatchStamping
@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ContentOverlay.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ContentOverlay.h"
+
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace ContentOverlay {
+
+  void AppendNumber(double value, std::string& operators) {
+    char buffer[32];
+    if (value == std::floor(value) && std::fabs(value) < 1e9)
+      snprintf(buffer, sizeof(buffer), "%.0f", value);
+    else {
+      snprintf(buffer, sizeof(buffer), "%.4f", value);
+      // strip trailing zeros of the fraction
+      char* end = buffer + strlen(buffer) - 1;
+      while (*end == '0')
+        *end-- = '\0';
+      if (*end == '.')
+        *end = '\0';
+    }
+    operators += buffer;
+    operators += ' ';
+  }
+
+  OverlayWriter::OverlayWriter(PdfDoc* doc) : m_doc(doc) {}
+
+  PdsStream* OverlayWriter::CreateContentStream(const std::string& operators) {
+    auto dict = m_doc->CreateDictObject(false);
+    if (!dict)
+      throw PdfixException();
+    auto stream = m_doc->CreateStreamObject(true, dict, (const uint8_t*)operators.data(),
+      (int)operators.size());
+    if (!stream)
+      throw PdfixException();
+    return stream;
+  }
+
+  PdsDictionary* OverlayWriter::GetResourceDict(PdfPage* page, const wchar_t* category) {
+    // resources may be inherited from the page tree, new entries are added to the inherited
+    // dictionary so the page keeps seeing the other ones
+    auto page_dict = page->GetObject();
+    PdsDictionary* resources = nullptr;
+    for (auto dict = page_dict; dict && !resources; dict = dict->GetDictionary(L"Parent"))
+      resources = dict->GetDictionary(L"Resources");
+    if (!resources)
+      resources = page_dict->PutDict(L"Resources");
+    if (!resources)
+      throw PdfixException();
+
+    auto category_dict = resources->GetDictionary(category);
+    if (!category_dict)
+      category_dict = resources->PutDict(category);
+    if (!category_dict)
+      throw PdfixException();
+    return category_dict;
+  }
+
+  void OverlayWriter::AppendOpacity(PdfPage* page, float opacity, std::string& operators) {
+    if (opacity >= 1.f)
+      return;
+    int key = (int)std::lround(std::max(0.f, opacity) * 1000);
+    auto& gstate = m_gstates[key];
+    if (!gstate) {
+      gstate = m_doc->CreateDictObject(true);
+      if (!gstate)
+        throw PdfixException();
+      gstate->PutName(L"Type", L"ExtGState");
+      gstate->PutNumber(L"ca", key / 1000.);
+      gstate->PutNumber(L"CA", key / 1000.);
+    }
+    auto gstate_name = L"PdfixGs" + std::to_wstring(gstate->GetId());
+    auto gstates = GetResourceDict(page, L"ExtGState");
+    if (!gstates->Known(gstate_name.c_str()))
+      gstates->Put(gstate_name.c_str(), gstate);
+    operators += '/' + ToUtf8(gstate_name) + " gs ";
+  }
+
+  void OverlayWriter::DrawXObject(PdfPage* page, PdsStream* xobj, const PdfMatrix& matrix, float opacity,
+    std::string& operators) {
+    // names derived from object ids stay the same when a page is stamped repeatedly
+    auto xobj_name = L"PdfixOv" + std::to_wstring(xobj->GetId());
+    auto xobjects = GetResourceDict(page, L"XObject");
+    if (!xobjects->Known(xobj_name.c_str()))
+      xobjects->Put(xobj_name.c_str(), xobj);
+
+    operators += "q ";
+    AppendOpacity(page, opacity, operators);
+    for (auto value : { matrix.a, matrix.b, matrix.c, matrix.d, matrix.e, matrix.f })
+      AppendNumber(value, operators);
+    operators += "cm /" + ToUtf8(xobj_name) + " Do Q\n";
+  }
+
+  void OverlayWriter::DrawText(PdfPage* page, PdsDictionary* font, double font_size, const PdfPoint& pos,
+    const std::string& text, float opacity, std::string& operators) {
+    auto font_name = L"PdfixFt" + std::to_wstring(font->GetId());
+    auto fonts = GetResourceDict(page, L"Font");
+    if (!fonts->Known(font_name.c_str()))
+      fonts->Put(font_name.c_str(), font);
+
+    operators += "q ";
+    AppendOpacity(page, opacity, operators);
+    operators += "BT /" + ToUtf8(font_name) + ' ';
+    AppendNumber(font_size, operators);
+    operators += "Tf ";
+    AppendNumber(pos.x, operators);
+    AppendNumber(pos.y, operators);
+    operators += "Td (";
+    for (auto ch : text) {
+      if (ch == '(' || ch == ')' || ch == '\\')
+        operators += '\\';
+      operators += ch;
+    }
+    operators += ") Tj ET Q\n";
+  }
+
+  void OverlayWriter::Write(PdfPage* page, const std::string& operators, Layer layer) {
+    auto page_dict = page->GetObject();
+    auto contents = page_dict->GetArray(L"Contents");
+    if (!contents) {
+      // a single content stream becomes the only item of a new array
+      auto original = page_dict->GetStream(L"Contents");
+      contents = m_doc->CreateArrayObject(false);
+      if (!contents)
+        throw PdfixException();
+      if (original)
+        contents->Insert(0, original);
+      if (!page_dict->Put(L"Contents", contents))
+        throw PdfixException();
+      contents = page_dict->GetArray(L"Contents");
+      if (!contents)
+        throw PdfixException();
+    }
+
+    if (layer == kLayerUnderlay) {
+      // the underlay restores the initial graphics state for the original content
+      if (!contents->Insert(0, CreateContentStream("q\n" + operators + "Q\n")))
+        throw PdfixException();
+      return;
+    }
+
+    // the original content may leave the graphics state changed, it is enclosed in q/Q
+    if (!m_save_state)
+      m_save_state = CreateContentStream("q\n");
+    if (!contents->Insert(0, m_save_state))
+      throw PdfixException();
+    if (!contents->Insert(contents->GetNumObjects(), CreateContentStream("Q\n" + operators)))
+      throw PdfixException();
+  }
+
+  void Benchmark(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& img_path,         // image to stamp
+    std::ostream& output                  // output stream for the report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfImageFormat format = kImageFormatJpg;
+    if ((img_path.rfind(L".png") != std::wstring::npos)
+      || (img_path.rfind(L".PNG") != std::wstring::npos))
+      format = kImageFormatPng;
+
+    auto stamp = [&](const char* method, bool append_only) {
+      auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+      std::unique_ptr<PdfDoc, decltype(doc_deleter)> doc(pdfix->OpenDoc(open_path.c_str(), L""), doc_deleter);
+      if (!doc)
+        throw PdfixException();
+
+      auto image_stm = pdfix->CreateFileStream(img_path.c_str(), kPsReadOnly);
+      if (!image_stm)
+        throw PdfixException();
+      auto image_obj = doc->CreateXObjectFromImage(image_stm, format);
+      image_stm->Destroy();
+      if (!image_obj)
+        throw PdfixException();
+      auto image_dict = image_obj->GetStreamDict();
+      PdfMatrix matrix;
+      matrix.a = image_dict->GetNumber(L"Width");
+      matrix.d = image_dict->GetNumber(L"Height");
+      matrix.e = 36;
+      matrix.f = 36;
+
+      auto clock_start = std::chrono::steady_clock::now();
+      OverlayWriter writer(doc.get());
+      std::string operators;
+      auto num_pages = doc->GetNumPages();
+      for (int i = 0; i < num_pages; i++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+
+        if (append_only) {
+          operators.clear();
+          writer.DrawXObject(page.get(), image_obj, matrix, 0.5f, operators);
+          writer.Write(page.get(), operators, kLayerOverlay);
+        }
+        else {
+          auto content = page->GetContent();
+          if (!content)
+            throw PdfixException();
+          auto image = content->AddNewImage(-1, image_obj, &matrix);
+          if (!image)
+            throw PdfixException();
+          auto gstate = image->GetGState();
+          gstate.color_state.fill_opacity = 128;
+          image->SetGState(&gstate);
+          if (!page->SetContent())
+            throw PdfixException();
+        }
+      }
+
+      auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+      std::unique_ptr<PsStream, decltype(stm_deleter)> stm(pdfix->CreateMemStream(), stm_deleter);
+      if (!stm)
+        throw PdfixException();
+      if (!doc->SaveToStream(stm.get(), kSaveFull))
+        throw PdfixException();
+      auto clock_end = std::chrono::steady_clock::now();
+
+      double seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+      output << method << ": " << num_pages << " pages in " << seconds << " s";
+      if (seconds > 0)
+        output << " (" << num_pages / seconds << " pages/s)";
+      output << ", saved " << stm->GetSize() << " bytes" << std::endl;
+      return seconds;
+    };
+
+    double set_content = stamp("SetContent", false);
+    double append_only = stamp("appended stream", true);
+    if (append_only > 0)
+      output << "speedup: " << set_content / append_only << std::endl;
+
+    pdfix->Destroy();
+  }
+} // namespace ContentOverlay
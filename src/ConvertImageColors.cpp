@@ -0,0 +1,575 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ConvertImageColors.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ConvertImageColors.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <mutex>
+#include <chrono>
+#include <initializer_list>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace ConvertImageColors {
+
+  // The loops below have no branches and no dependencies between pixels, compilers turn them
+  // into SIMD code at -O2/-O3 (/O2 with MSVC).
+
+  void RGBToCMYK(const uint8_t* src, uint8_t* dst, size_t pixel_count) {
+    for (size_t i = 0; i < pixel_count; i++) {
+      int r = src[3 * i];
+      int g = src[3 * i + 1];
+      int b = src[3 * i + 2];
+      int max = std::max(r, std::max(g, b));
+      // c = (1 - r - k) / (1 - k) with k = 1 - max, black for max = 0
+      float scale = 255.f / (float)std::max(max, 1);
+      dst[4 * i] = (uint8_t)((float)(max - r) * scale + 0.5f);
+      dst[4 * i + 1] = (uint8_t)((float)(max - g) * scale + 0.5f);
+      dst[4 * i + 2] = (uint8_t)((float)(max - b) * scale + 0.5f);
+      dst[4 * i + 3] = (uint8_t)(255 - max);
+    }
+  }
+
+  void RGBToGray(const uint8_t* src, uint8_t* dst, size_t pixel_count) {
+    // ITU-R BT.601 luma in 8-bit fixed point
+    for (size_t i = 0; i < pixel_count; i++) {
+      unsigned y = 77u * src[3 * i] + 150u * src[3 * i + 1] + 29u * src[3 * i + 2] + 128u;
+      dst[i] = (uint8_t)(y >> 8);
+    }
+  }
+
+  void CMYKToRGB(const uint8_t* src, uint8_t* dst, size_t pixel_count) {
+    for (size_t i = 0; i < pixel_count; i++) {
+      unsigned k_inv = 255u - src[4 * i + 3];
+      for (int c = 0; c < 3; c++) {
+        // (255 - c) * (255 - k) / 255 rounded, division by 255 without a divide
+        unsigned x = (255u - src[4 * i + c]) * k_inv + 128u;
+        dst[3 * i + c] = (uint8_t)((x + (x >> 8)) >> 8);
+      }
+    }
+  }
+
+  void LzwEncode(const uint8_t* data, size_t size, std::vector<uint8_t>& encoded) {
+    const int kClear = 256;
+    const int kEndOfData = 257;
+    const int kFirstCode = 258;
+    const int kMaxCode = 4094;            // table is reset before codes need 13 bits
+    const int kTableSize = 8192;          // open addressing table of (prefix, byte) pairs
+
+    std::vector<int32_t> keys(kTableSize, -1);
+    std::vector<int16_t> codes(kTableSize);
+    int next_code = kFirstCode;
+    int width = 9;
+    uint32_t bits = 0;
+    int bit_count = 0;
+
+    encoded.clear();
+    encoded.reserve(size / 2 + 16);
+    auto emit = [&](int code) {
+      bits = (bits << width) | (uint32_t)code;
+      bit_count += width;
+      while (bit_count >= 8) {
+        bit_count -= 8;
+        encoded.push_back((uint8_t)(bits >> bit_count));
+      }
+      bits &= (1u << bit_count) - 1;
+    };
+    auto reset = [&]() {
+      std::fill(keys.begin(), keys.end(), -1);
+      next_code = kFirstCode;
+      width = 9;
+    };
+    // with EarlyChange the decoder widens codes one entry before the table needs it, the
+    // encoder counts the entry the decoder adds after reading the code
+    auto add_code = [&]() {
+      next_code++;
+      if (next_code >= kMaxCode) {
+        emit(kClear);
+        reset();
+      }
+      else if (next_code == (1 << width))
+        width++;
+    };
+
+    emit(kClear);
+    if (size > 0) {
+      int prefix = data[0];
+      for (size_t i = 1; i < size; i++) {
+        int32_t key = (prefix << 8) | data[i];
+        uint32_t slot = ((uint32_t)key * 2654435761u) >> 19;
+        while (keys[slot] != -1 && keys[slot] != key)
+          slot = (slot + 1) & (kTableSize - 1);
+        if (keys[slot] == key) {
+          prefix = codes[slot];
+          continue;
+        }
+        emit(prefix);
+        keys[slot] = key;
+        codes[slot] = (int16_t)next_code;
+        add_code();
+        prefix = data[i];
+      }
+      emit(prefix);
+      add_code();
+    }
+    emit(kEndOfData);
+    if (bit_count > 0)
+      encoded.push_back((uint8_t)(bits << (8 - bit_count)));
+  }
+
+  static std::wstring GetName(PdsDictionary* dict, const wchar_t* key) {
+    auto object = dict->Get(key);
+    if (!object || object->GetObjectType() != kPdsName)
+      return L"";
+    return ((PdsName*)object)->GetText();
+  }
+
+  // number of components of device and ICC based color spaces, 0 for others
+  static int GetColorComponents(PdsDictionary* dict) {
+    auto color_space = dict->Get(L"ColorSpace");
+    if (!color_space)
+      return 0;
+    std::wstring family;
+    if (color_space->GetObjectType() == kPdsName)
+      family = ((PdsName*)color_space)->GetText();
+    else if (color_space->GetObjectType() == kPdsArray) {
+      auto cs_array = (PdsArray*)color_space;
+      if (cs_array->GetText(0) == L"ICCBased") {
+        auto icc = cs_array->GetStream(1);
+        return icc ? (int)icc->GetStreamDict()->GetNumber(L"N") : 0;
+      }
+    }
+    if (family == L"DeviceGray")
+      return 1;
+    if (family == L"DeviceRGB")
+      return 3;
+    if (family == L"DeviceCMYK")
+      return 4;
+    return 0;
+  }
+
+  // image codecs are not decoded by PdsStream::Read
+  static bool IsDecodable(PdsDictionary* dict) {
+    auto filter = dict->Get(L"Filter");
+    if (!filter)
+      return true;
+    std::vector<std::wstring> filters;
+    if (filter->GetObjectType() == kPdsName)
+      filters.push_back(((PdsName*)filter)->GetText());
+    else if (filter->GetObjectType() == kPdsArray) {
+      auto filter_array = (PdsArray*)filter;
+      for (int i = 0; i < filter_array->GetNumObjects(); i++)
+        filters.push_back(filter_array->GetText(i));
+    }
+    for (auto& name : filters) {
+      if (name == L"DCTDecode" || name == L"JPXDecode" || name == L"JBIG2Decode" ||
+        name == L"CCITTFaxDecode")
+        return false;
+    }
+    return true;
+  }
+
+  // Serializes the object for comparison, indirect objects by their id. Images sharing a
+  // converted XObject must agree on masks, color space, optional content and other entries.
+  static void AppendEntries(PdsObject* object, std::wstring& entries) {
+    if (!object) {
+      entries += L"null ";
+      return;
+    }
+    if (object->GetId() != 0) {
+      entries += L"#" + std::to_wstring(object->GetId()) + L" ";
+      return;
+    }
+    switch (object->GetObjectType()) {
+    case kPdsBoolean:
+      entries += ((PdsBoolean*)object)->GetValue() ? L"true " : L"false ";
+      break;
+    case kPdsNumber:
+      entries += std::to_wstring(((PdsNumber*)object)->GetValue()) + L" ";
+      break;
+    case kPdsName:
+      entries += L"/" + ((PdsName*)object)->GetText() + L" ";
+      break;
+    case kPdsString:
+      entries += L"(" + ((PdsString*)object)->GetText() + L") ";
+      break;
+    case kPdsArray: {
+      auto array = (PdsArray*)object;
+      entries += L"[ ";
+      for (int i = 0; i < array->GetNumObjects(); i++)
+        AppendEntries(array->Get(i), entries);
+      entries += L"] ";
+      break;
+    }
+    case kPdsDictionary: {
+      auto dict = (PdsDictionary*)object;
+      entries += L"<< ";
+      for (int i = 0; i < dict->GetNumKeys(); i++) {
+        auto key = dict->GetKey(i);
+        entries += L"/" + key + L" ";
+        AppendEntries(dict->Get(key.c_str()), entries);
+      }
+      entries += L">> ";
+      break;
+    }
+    default:
+      entries += L"? ";
+    }
+  }
+
+  // entries of the image dictionary except those describing the encoded data
+  static std::wstring GetImageEntries(PdsDictionary* dict) {
+    std::vector<std::wstring> keys;
+    for (int i = 0; i < dict->GetNumKeys(); i++) {
+      auto key = dict->GetKey(i);
+      if (key != L"Length" && key != L"Filter" && key != L"DecodeParms")
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::wstring entries;
+    for (auto& key : keys) {
+      entries += L"/" + key + L" ";
+      AppendEntries(dict->Get(key.c_str()), entries);
+    }
+    return entries;
+  }
+
+  // copies entries of the dictionary except the skipped ones, the values are shared
+  static void CopyEntries(PdsDictionary* from, PdsDictionary* to,
+    std::initializer_list<const wchar_t*> skipped) {
+    for (int i = 0; i < from->GetNumKeys(); i++) {
+      auto key = from->GetKey(i);
+      auto is_skipped = [&](const wchar_t* name) { return key == name; };
+      if (std::any_of(skipped.begin(), skipped.end(), is_skipped))
+        continue;
+      if (!to->Put(key.c_str(), from->Get(key.c_str())))
+        throw PdfixException();
+    }
+  }
+
+  // image XObject and the resource entries referring to it
+  struct ImageEntry {
+    PdsStream* stream = nullptr;
+    std::vector<std::pair<PdsDictionary*, std::wstring>> refs;
+    int width = 0;
+    int height = 0;
+    std::wstring entries;                 // dictionary entries other images must match to be shared
+    std::vector<uint8_t> encoded;         // converted and compressed pixels
+    int same_as = -1;                     // index of the entry with identical pixels
+    bool converted = false;
+  };
+
+  // collects images of the resources and of forms they use
+  static void CollectImages(PdsDictionary* resources, std::set<int>& visited,
+    std::map<int, size_t>& image_index, std::vector<ImageEntry>& images) {
+    if (!resources || (resources->GetId() != 0 && !visited.insert(resources->GetId()).second))
+      return;
+    auto xobjects = resources->GetDictionary(L"XObject");
+    if (!xobjects)
+      return;
+    for (int i = 0; i < xobjects->GetNumKeys(); i++) {
+      auto key = xobjects->GetKey(i);
+      auto stream = xobjects->GetStream(key.c_str());
+      if (!stream)
+        continue;
+      auto dict = stream->GetStreamDict();
+      auto subtype = GetName(dict, L"Subtype");
+      if (subtype == L"Image") {
+        auto found = image_index.find(stream->GetId());
+        if (found == image_index.end()) {
+          found = image_index.emplace(stream->GetId(), images.size()).first;
+          images.emplace_back();
+          images.back().stream = stream;
+        }
+        images[found->second].refs.emplace_back(xobjects, key);
+      }
+      else if (subtype == L"Form" && visited.insert(stream->GetId()).second)
+        CollectImages(dict->GetDictionary(L"Resources"), visited, image_index, images);
+    }
+  }
+
+  // Copies the soft mask with its Matte color converted to the color space of the converted image,
+  // the mask may be shared by images which are not converted.
+  static PdsStream* ConvertMatteMask(PdfDoc* doc, PdsStream* smask, int src_components,
+    int dst_components, void (*kernel)(const uint8_t*, uint8_t*, size_t)) {
+    auto old_dict = smask->GetStreamDict();
+    std::vector<uint8_t> data(std::max(smask->GetSize(), 0));
+    if (!data.empty() && !smask->Read(0, data.data(), (int)data.size()))
+      throw PdfixException();
+    std::vector<uint8_t> encoded;
+    LzwEncode(data.data(), data.size(), encoded);
+
+    uint8_t src[4] = { 0 };
+    uint8_t dst[4] = { 0 };
+    auto matte = old_dict->GetArray(L"Matte");
+    for (int c = 0; matte && c < src_components && c < matte->GetNumObjects(); c++)
+      src[c] = (uint8_t)(std::min(std::max(matte->GetNumber(c), 0.), 1.) * 255. + 0.5);
+    kernel(src, dst, 1);
+
+    auto dict = doc->CreateDictObject(false);
+    if (!dict)
+      throw PdfixException();
+    CopyEntries(old_dict, dict, { L"Length", L"Filter", L"DecodeParms", L"Matte" });
+    if (!dict->PutName(L"Filter", L"LZWDecode"))
+      throw PdfixException();
+    auto new_matte = dict->PutArray(L"Matte");
+    if (!new_matte)
+      throw PdfixException();
+    for (int c = 0; c < dst_components; c++) {
+      if (!new_matte->InsertNumber(c, dst[c] / 255.))
+        throw PdfixException();
+    }
+    auto stream = doc->CreateStreamObject(true, dict, encoded.data(), (int)encoded.size());
+    if (!stream)
+      throw PdfixException();
+    return stream;
+  }
+
+  void ConvertImages(PdfDoc* doc, ColorConversion conversion, size_t thread_count, Stats& stats) {
+    auto clock_start = std::chrono::steady_clock::now();
+    const int src_components = conversion == kCMYKToRGB ? 4 : 3;
+    const int dst_components = conversion == kRGBToCMYK ? 4 : conversion == kRGBToGray ? 1 : 3;
+    const wchar_t* dst_color_space = conversion == kRGBToCMYK ? L"DeviceCMYK" :
+      conversion == kRGBToGray ? L"DeviceGray" : L"DeviceRGB";
+
+    // stage 1: find image XObjects in page resources, inherited resources included
+    std::set<int> visited;
+    std::map<int, size_t> image_index;
+    std::vector<ImageEntry> images;
+    for (int i = 0; i < doc->GetNumPages(); i++) {
+      auto page = doc->AcquirePage(i);
+      if (!page)
+        throw PdfixException();
+      PdsDictionary* resources = nullptr;
+      for (auto dict = page->GetObject(); dict && !resources; dict = dict->GetDictionary(L"Parent"))
+        resources = dict->GetDictionary(L"Resources");
+      CollectImages(resources, visited, image_index, images);
+      page->Release();
+    }
+    stats.images = images.size();
+
+    auto kernel = conversion == kRGBToCMYK ? RGBToCMYK :
+      conversion == kRGBToGray ? RGBToGray : CMYKToRGB;
+
+    // reads pixels of an image which can be converted, other images are left as they are
+    auto read_pixels = [&](ImageEntry& image, std::vector<uint8_t>& data) {
+      auto dict = image.stream->GetStreamDict();
+      image.width = dict->GetInteger(L"Width", 0);
+      image.height = dict->GetInteger(L"Height", 0);
+      size_t pixel_count = (size_t)image.width * image.height;
+      if (pixel_count == 0 || dict->GetInteger(L"BitsPerComponent", 0) != 8 ||
+        dict->GetBoolean(L"ImageMask", false) || dict->Known(L"Decode") ||
+        GetColorComponents(dict) != src_components || !IsDecodable(dict))
+        return false;
+      // color key masks are given in the source components
+      auto mask = dict->Get(L"Mask");
+      if (mask && mask->GetObjectType() == kPdsArray)
+        return false;
+      // the matte color of a soft mask is converted with a decoded copy of the mask
+      auto smask = dict->GetStream(L"SMask");
+      if (smask && smask->GetStreamDict()->Known(L"Matte") && !IsDecodable(smask->GetStreamDict()))
+        return false;
+
+      data.resize(image.stream->GetSize());
+      if (data.size() < pixel_count * src_components)
+        return false;
+      if (!image.stream->Read(0, data.data(), (int)data.size()))
+        throw PdfixException();
+      return true;
+    };
+
+    std::mutex mutex;
+    auto convert_pixels = [&](ImageEntry& image, const std::vector<uint8_t>& data,
+      std::vector<uint8_t>& converted) {
+      size_t pixel_count = (size_t)image.width * image.height;
+      auto kernel_start = std::chrono::steady_clock::now();
+      converted.resize(pixel_count * dst_components);
+      kernel(data.data(), converted.data(), pixel_count);
+      auto kernel_end = std::chrono::steady_clock::now();
+
+      LzwEncode(converted.data(), converted.size(), image.encoded);
+      image.converted = true;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      stats.kernel_seconds += std::chrono::duration<double>(kernel_end - kernel_start).count();
+      stats.megapixels += pixel_count / 1e6;
+    };
+
+    // stage 2: decode, convert and compress unique images in parallel
+    std::map<uint64_t, int> pixel_hashes;
+    auto convert_images = [&](int from, int to) {
+      std::vector<uint8_t> data;
+      std::vector<uint8_t> converted;
+      for (int i = from; i <= to; i++) {
+        auto& image = images[i];
+        if (!read_pixels(image, data))
+          continue;
+
+        // images with the same pixels and dictionary entries (size, masks, color space object)
+        // are converted once, hash hits are confirmed in stage 3
+        image.entries = GetImageEntries(image.stream->GetStreamDict());
+        auto hash = HashBytes(data.data(), (size_t)image.width * image.height * src_components);
+        hash = HashBytes(image.entries.data(), image.entries.size() * sizeof(wchar_t), hash);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          auto found = pixel_hashes.emplace(hash, i);
+          if (!found.second) {
+            image.same_as = found.first->second;
+            continue;
+          }
+        }
+        convert_pixels(image, data, converted);
+      }
+    };
+    ParallelFor(0, (int)images.size() - 1, thread_count, convert_images);
+
+    // stage 3: confirm duplicates byte by byte, images which only share the hash are converted
+    // here, both images are read again as stage 2 keeps no pixels
+    {
+      std::vector<uint8_t> data, same_data, converted;
+      for (size_t i = 0; i < images.size(); i++) {
+        auto& image = images[i];
+        if (image.same_as == -1)
+          continue;
+        auto& same = images[image.same_as];
+        size_t size = (size_t)image.width * image.height * src_components;
+        bool readable = read_pixels(image, data);
+        bool equal = readable && image.entries == same.entries && read_pixels(same, same_data) &&
+          std::equal(data.begin(), data.begin() + size, same_data.begin());
+        if (!equal) {
+          image.same_as = -1;
+          if (readable)
+            convert_pixels(image, data, converted);
+        }
+      }
+    }
+
+    // stage 4: create the converted XObjects and point the resources to them, entries other than
+    // the color space and the encoding are kept
+    std::map<int, PdsStream*> new_smasks;
+    std::vector<PdsStream*> new_streams(images.size(), nullptr);
+    for (size_t i = 0; i < images.size(); i++) {
+      auto& image = images[i];
+      if (!image.converted)
+        continue;
+      auto old_dict = image.stream->GetStreamDict();
+      auto dict = doc->CreateDictObject(false);
+      if (!dict)
+        throw PdfixException();
+      CopyEntries(old_dict, dict,
+        { L"Length", L"Filter", L"DecodeParms", L"ColorSpace", L"SMask" });
+      if (!dict->PutName(L"ColorSpace", dst_color_space) || !dict->PutName(L"Filter", L"LZWDecode"))
+        throw PdfixException();
+
+      auto smask = old_dict->GetStream(L"SMask");
+      if (smask && smask->GetStreamDict()->Known(L"Matte")) {
+        auto& new_smask = new_smasks[smask->GetId()];
+        if (!new_smask)
+          new_smask = ConvertMatteMask(doc, smask, src_components, dst_components, kernel);
+        smask = new_smask;
+      }
+      if (smask && !dict->Put(L"SMask", smask))
+        throw PdfixException();
+
+      new_streams[i] = doc->CreateStreamObject(true, dict, image.encoded.data(), (int)image.encoded.size());
+      if (!new_streams[i])
+        throw PdfixException();
+      image.encoded = std::vector<uint8_t>();
+      stats.converted++;
+    }
+
+    for (size_t i = 0; i < images.size(); i++) {
+      auto& image = images[i];
+      auto stream = new_streams[image.same_as == -1 ? i : image.same_as];
+      if (!stream) {
+        stats.skipped++;
+        continue;
+      }
+      if (image.same_as != -1)
+        stats.duplicates++;
+      for (auto& ref : image.refs)
+        ref.first->Put(ref.second.c_str(), stream);
+    }
+
+    auto clock_end = std::chrono::steady_clock::now();
+    stats.seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+  }
+
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& save_path,        // output PDF document
+    ColorConversion conversion,           // conversion applied to the images
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    Stats stats;
+    ConvertImages(doc, conversion, thread_count, stats);
+
+    output << "images: " << stats.images << ", converted: " << stats.converted << ", duplicates: "
+      << stats.duplicates << ", skipped: " << stats.skipped << std::endl;
+    output << stats.megapixels << " MP in " << stats.seconds << " s";
+    if (stats.seconds > 0)
+      output << " (" << stats.megapixels / stats.seconds << " MP/s overall";
+    if (stats.kernel_seconds > 0)
+      output << ", " << stats.megapixels / stats.kernel_seconds << " MP/s in kernels";
+    if (stats.seconds > 0)
+      output << ")";
+    output << std::endl;
+
+    if (!doc->Save(save_path.c_str(), kSaveFull))
+      throw PdfixException();
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+
+  void BenchmarkKernels(size_t megapixels, std::ostream& output) {
+    size_t pixel_count = megapixels * 1000000;
+    std::vector<uint8_t> src(pixel_count * 4);
+    for (size_t i = 0; i < src.size(); i++)
+      src[i] = (uint8_t)((i * 7 + (i >> 10)) & 0xFF);
+    std::vector<uint8_t> dst(pixel_count * 4);
+
+    auto measure = [&](const char* name, void (*kernel)(const uint8_t*, uint8_t*, size_t)) {
+      auto clock_start = std::chrono::steady_clock::now();
+      kernel(src.data(), dst.data(), pixel_count);
+      auto clock_end = std::chrono::steady_clock::now();
+      double seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+      output << name << ": " << megapixels << " MP in " << seconds << " s";
+      if (seconds > 0)
+        output << " (" << megapixels / seconds << " MP/s)";
+      output << std::endl;
+    };
+    measure("RGB to CMYK", RGBToCMYK);
+    measure("RGB to Gray", RGBToGray);
+    measure("CMYK to RGB", CMYKToRGB);
+
+    auto clock_start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> encoded;
+    LzwEncode(dst.data(), pixel_count * 4, encoded);
+    auto clock_end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+    output << "LZW: " << pixel_count * 4 / 1e6 << " MB to " << encoded.size() / 1e6 << " MB in "
+      << seconds << " s" << std::endl;
+  }
+} // namespace ConvertImageColors
@@ -1,93 +1,328 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ConvertRGBToCMYK.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "pdfixsdksamples/ConvertRGBToCMYK.h"
-#include  <cassert>
 #include <algorithm>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include "pdfixsdksamples/Utils.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
-PdfColorSpace* gCMYKColorSpace = nullptr;
+// see: https://www.rapidtables.com/convert/color/rgb-to-cmyk.html
+static void RGBToCMYK(double r, double g, double b, double cmyk[4]) {
+  auto k = 1.0 - std::max(r, std::max(g, b));
+  auto k_inv_recip = (k == 1.0) ? 0.0 : (1.0 / (1.0 - k));
+  cmyk[0] = (1.0 - r - k) * k_inv_recip;
+  cmyk[1] = (1.0 - g - k) * k_inv_recip;
+  cmyk[2] = (1.0 - b - k) * k_inv_recip;
+  cmyk[3] = k;
+}
+
+// Conversion state of one document shared by all page workers. Converted colors are created
+// once per distinct RGB value, forms and shadings are converted once per object.
+class CMYKConverter {
+  PdfColorSpace* m_cmyk_color_space;
+  std::mutex m_mutex;
+  std::map<std::tuple<float, float, float>, PdfColor*> m_colors;
+  std::set<int> m_converted;          // ids of converted forms, shadings and functions
+  std::map<int, PdsStream*> m_forms;  // converted form streams by id of the original form
+
+public:
+  CMYKConverter(PdfDoc* doc) {
+    m_cmyk_color_space = doc->CreateColorSpace(PdfColorSpaceFamily::kColorSpaceDeviceCMYK);
+    if (!m_cmyk_color_space)
+      throw PdfixException();
+  }
+
+  ~CMYKConverter() {
+    for (auto& color : m_colors)
+      color.second->Destroy();
+  }
+
+  // returns the CMYK equivalent of an RGB color, nullptr for other colors
+  PdfColor* GetColor(PdfColor* color) {
+    auto color_space = color->GetColorSpace();
+    if (!color_space || color_space->GetFamilyType() != kColorSpaceDeviceRGB)
+      return nullptr;
 
-static PdfColor* ConvertRGBToCMYK(PdfColor* color) {
-  assert(gCMYKColorSpace != nullptr);
+    auto key = std::make_tuple(color->GetValue(0), color->GetValue(1), color->GetValue(2));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& result = m_colors[key];
+    if (!result) {
+      result = m_cmyk_color_space->CreateColor();
+      if (!result)
+        throw PdfixException();
+      double cmyk[4];
+      RGBToCMYK(std::get<0>(key), std::get<1>(key), std::get<2>(key), cmyk);
+      for (int i = 0; i < 4; i++)
+        result->SetValue(i, (float)cmyk[i]);
+    }
+    return result;
+  }
 
-  PdfColor* result = color;
+  // true for the first caller with the object id, direct objects are always claimed
+  bool Claim(int id) {
+    if (id == 0)
+      return true;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_converted.insert(id).second;
+  }
 
-  auto color_space = color->GetColorSpace();
-  if (color_space && (color_space->GetFamilyType() == kColorSpaceDeviceRGB)) {
-    // create color in cmyk color space
-    result = gCMYKColorSpace->CreateColor();
-    // set cmyk color values
-    // see: https://www.rapidtables.com/convert/color/rgb-to-cmyk.html
-    auto r = color->GetValue(0);
-    auto g = color->GetValue(1);
-    auto b = color->GetValue(2);
+  void SetForm(int id, PdsStream* stream) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_forms[id] = stream;
+  }
 
-    auto k = 1.0 - std::max(r, std::max(g, b));
-    auto k_inv_recip = (k == 1.0) ? 0.0 : (1.0 / (1.0 - k));
-    auto c = (1.0 - r - k) * k_inv_recip;
-    auto m = (1.0 - g - k) * k_inv_recip;
-    auto y = (1.0 - b - k) * k_inv_recip;
+  // forms are written only by the serial passes, no lock is needed to read them
+  const std::map<int, PdsStream*>& GetForms() const { return m_forms; }
 
-    result->SetValue(0, c);
-    result->SetValue(1, m);
-    result->SetValue(2, y);
-    result->SetValue(3, k);
+  size_t GetNumColors() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_colors.size();
   }
+};
 
-  return result;
+// Replaces RGB colors of the color state. Colors returned by GetGState and GetTextState are
+// owned by the caller and collected to be destroyed after the state is set.
+static bool ConvertColorState(CMYKConverter& converter, PdfColorState& color_state,
+  std::vector<PdfColor*>& originals) {
+  bool converted = false;
+  for (auto color : { &color_state.stroke_color, &color_state.fill_color }) {
+    if (!*color)
+      continue;
+    originals.push_back(*color);
+    auto cmyk = converter.GetColor(*color);
+    if (cmyk) {
+      *color = cmyk;
+      converted = true;
+    }
+  }
+  return converted;
 }
 
-static void ConvertRGBToCMYK(PdfColorState& color_state) {
-  if (color_state.stroke_type != kFillTypeNone) {
-    color_state.stroke_color = ConvertRGBToCMYK(color_state.stroke_color);
+static bool ReadRGB(PdsArray* array, double rgb[3]) {
+  if (!array || array->GetNumObjects() != 3)
+    return false;
+  for (int i = 0; i < 3; i++)
+    rgb[i] = array->GetNumber(i);
+  return true;
+}
+
+static void WriteCMYK(PdsDictionary* dict, const wchar_t* key, const double rgb[3]) {
+  double cmyk[4];
+  RGBToCMYK(rgb[0], rgb[1], rgb[2], cmyk);
+  auto array = dict->PutArray(key);
+  if (!array)
+    throw PdfixException();
+  for (int i = 0; i < 4; i++)
+    array->PutNumber(i, cmyk[i]);
+}
+
+// exponential (type 2) functions and stitching (type 3) functions made of them can be converted
+static bool CanConvertFunction(PdsDictionary* function) {
+  if (!function)
+    return false;
+  double rgb[3];
+  switch (function->GetInteger(L"FunctionType", -1)) {
+  case 2:
+    return ReadRGB(function->GetArray(L"C0"), rgb) && ReadRGB(function->GetArray(L"C1"), rgb);
+  case 3: {
+    auto functions = function->GetArray(L"Functions");
+    if (!functions)
+      return false;
+    for (int i = 0; i < functions->GetNumObjects(); i++) {
+      if (!CanConvertFunction(functions->GetDictionary(i)))
+        return false;
+    }
+    return true;
   }
-  if (color_state.fill_type != kFillTypeNone) {
-    color_state.fill_color = ConvertRGBToCMYK(color_state.fill_color);
+  default:
+    return false;
   }
 }
 
-static void ConvertRGBToCMYK(PdfPage* page) {
-  auto content = page->GetContent();
-  auto num_objects = content->GetNumObjects();
-  for (int i = 0; i < num_objects; i++) {
+static void ConvertFunction(CMYKConverter& converter, PdsDictionary* function) {
+  // functions shared by several shadings are converted once
+  if (!converter.Claim(function->GetId()))
+    return;
+  if (function->GetInteger(L"FunctionType", -1) == 2) {
+    double c0[3], c1[3];
+    ReadRGB(function->GetArray(L"C0"), c0);
+    ReadRGB(function->GetArray(L"C1"), c1);
+    WriteCMYK(function, L"C0", c0);
+    WriteCMYK(function, L"C1", c1);
+    return;
+  }
+  auto functions = function->GetArray(L"Functions");
+  for (int i = 0; i < functions->GetNumObjects(); i++)
+    ConvertFunction(converter, functions->GetDictionary(i));
+}
+
+// Converts axial and radial shadings with DeviceRGB color space.
+static bool ConvertShading(CMYKConverter& converter, PdsObject* object) {
+  if (!object || object->GetObjectType() != kPdsDictionary)
+    return false;
+  auto shading = (PdsDictionary*)object;
+  auto color_space = shading->Get(L"ColorSpace");
+  if (!color_space || color_space->GetObjectType() != kPdsName ||
+    ((PdsName*)color_space)->GetText() != L"DeviceRGB")
+    return false;
+  auto type = shading->GetInteger(L"ShadingType", 0);
+  if (type != 2 && type != 3)
+    return false;
+  auto function = shading->GetDictionary(L"Function");
+  if (!CanConvertFunction(function))
+    return false;
+  if (!converter.Claim(shading->GetId()))
+    return false;
+
+  ConvertFunction(converter, function);
+  double background[3];
+  if (ReadRGB(shading->GetArray(L"Background"), background))
+    WriteCMYK(shading, L"Background", background);
+  shading->PutName(L"ColorSpace", L"DeviceCMYK");
+  return true;
+}
+
+// Converts colors of a text, path or image object, forms and shadings are left to ConvertForm.
+static bool ConvertObject(CMYKConverter& converter, PdsPageObject* page_object) {
+  bool converted = false;
+  std::vector<PdfColor*> originals;
+  switch (page_object->GetObjectType()) {
+  case PdfPageObjectType::kPdsPageForm:
+  case PdfPageObjectType::kPdsPageShading:
+    break;
+  case PdfPageObjectType::kPdsPageText: {
+    auto text_object = (PdsText*)page_object;
+    auto t_state = text_object->GetTextState();
+    converted = ConvertColorState(converter, t_state.color_state, originals);
+    if (converted && !text_object->SetTextState(&t_state))
+      throw PdfixException();
+    break;
+  }
+  default: {
+    auto g_state = page_object->GetGState();
+    converted = ConvertColorState(converter, g_state.color_state, originals);
+    if (converted && !page_object->SetGState(&g_state))
+      throw PdfixException();
+    break;
+  }
+  }
+  for (auto color : originals)
+    color->Destroy();
+  return converted;
+}
+
+static int ConvertForm(CMYKConverter& converter, PdfDoc* doc, PdsForm* form);
+
+// Converts shadings and forms placed in the content, returns the number of converted objects.
+static int ConvertSharedObjects(CMYKConverter& converter, PdfDoc* doc, PdsContent* content) {
+  int converted = 0;
+  for (int i = 0; i < content->GetNumObjects(); i++) {
     auto page_object = content->GetObject(i);
-    if (page_object->GetObjectType() != PdfPageObjectType::kPdsPageText) {
-      auto g_state = page_object->GetGState();
-      auto& color_state = g_state.color_state;
-      ConvertRGBToCMYK(color_state);
-      page_object->SetGState(&g_state);
-      if (color_state.stroke_color)
-        color_state.stroke_color->Destroy();
-      if (color_state.fill_color)
-        color_state.fill_color->Destroy();
-    } else {
-      auto text_object = (PdsText*)page_object;
-      auto t_state = text_object->GetTextState();
-      auto& color_state = t_state.color_state;
-      ConvertRGBToCMYK(color_state);
-      text_object->SetTextState(&t_state);
-      if (color_state.stroke_color)
-        color_state.stroke_color->Destroy();
-      if (color_state.fill_color)
-        color_state.fill_color->Destroy();
-    }
+    if (page_object->GetObjectType() == PdfPageObjectType::kPdsPageForm)
+      converted += ConvertForm(converter, doc, (PdsForm*)page_object);
+    else if (page_object->GetObjectType() == PdfPageObjectType::kPdsPageShading &&
+      ConvertShading(converter, page_object->GetObject()))
+      converted++;
   }
+  return converted;
 }
 
-static void ConvertRGBToCMYK(PdfDoc* doc) {
-  auto num_pages = doc->GetNumPages();
-  for (int i = 0; i < num_pages; i++) {
-    auto page = doc->AcquirePage(i);
-    ConvertRGBToCMYK(page);
-    page->SetContent();
-    page->Release();
+// Converts the form and its nested forms once per form id. The converted content is written to a
+// new stream which replaces the form in the resources once all pages are converted.
+static int ConvertForm(CMYKConverter& converter, PdfDoc* doc, PdsForm* form) {
+  auto form_stream = form->GetObject();
+  if (!form_stream || form_stream->GetObjectType() != kPdsStream ||
+    !converter.Claim(form_stream->GetId()))
+    return 0;
+
+  auto content = form->GetContent();
+  int converted = ConvertSharedObjects(converter, doc, content);
+  int own_converted = 0;
+  for (int i = 0; i < content->GetNumObjects(); i++) {
+    if (ConvertObject(converter, content->GetObject(i)))
+      own_converted++;
+  }
+  if (own_converted == 0 || form_stream->GetId() == 0)
+    return converted + own_converted;
+
+  // nested forms are referred by their original ids, they are replaced with the rest
+  auto form_dict = ((PdsStream*)form_stream)->GetStreamDict();
+  PdsContentParams params;
+  params.flags = kContentForm;
+  params.form_type = 1;
+  auto bbox = form_dict->GetArray(L"BBox");
+  if (bbox && bbox->GetNumObjects() == 4) {
+    params.bbox.left = bbox->GetNumber(0);
+    params.bbox.bottom = bbox->GetNumber(1);
+    params.bbox.right = bbox->GetNumber(2);
+    params.bbox.top = bbox->GetNumber(3);
+  }
+  auto matrix = form_dict->GetArray(L"Matrix");
+  if (matrix && matrix->GetNumObjects() == 6) {
+    params.matrix.a = matrix->GetNumber(0);
+    params.matrix.b = matrix->GetNumber(1);
+    params.matrix.c = matrix->GetNumber(2);
+    params.matrix.d = matrix->GetNumber(3);
+    params.matrix.e = matrix->GetNumber(4);
+    params.matrix.f = matrix->GetNumber(5);
+  }
+  auto stream = content->ToObject(doc, &params);
+  if (!stream)
+    throw PdfixException();
+
+  // transparency group, optional content and other entries of the form are kept
+  auto stream_dict = stream->GetStreamDict();
+  for (int i = 0; i < form_dict->GetNumKeys(); i++) {
+    auto key = form_dict->GetKey(i);
+    if (stream_dict->Known(key.c_str()) || key == L"Length" || key == L"Filter" ||
+      key == L"DecodeParms")
+      continue;
+    if (!stream_dict->Put(key.c_str(), form_dict->Get(key.c_str())))
+      throw PdfixException();
+  }
+  converter.SetForm(form_stream->GetId(), stream);
+  return converted + own_converted;
+}
+
+// Points XObject resources to the converted forms, resources of forms are updated recursively.
+static void ReplaceForms(PdsDictionary* resources, const std::map<int, PdsStream*>& forms,
+  std::set<int>& visited) {
+  auto xobjects = resources ? resources->GetDictionary(L"XObject") : nullptr;
+  if (!xobjects)
+    return;
+  for (int i = 0; i < xobjects->GetNumKeys(); i++) {
+    auto key = xobjects->GetKey(i);
+    auto object = xobjects->Get(key.c_str());
+    if (!object || object->GetObjectType() != kPdsStream)
+      continue;
+    auto found = forms.find(object->GetId());
+    if (found != forms.end()) {
+      if (!xobjects->Put(key.c_str(), found->second))
+        throw PdfixException();
+      object = found->second;
+    }
+    if (object->GetId() != 0 && !visited.insert(object->GetId()).second)
+      continue;
+    auto form_dict = ((PdsStream*)object)->GetStreamDict();
+    ReplaceForms(form_dict->GetDictionary(L"Resources"), forms, visited);
   }
 }
 
 void ConvertRGBToCMYK(
   const std::wstring& open_path,      // source PDF document
-  const std::wstring& save_path       // output PDF document
+  const std::wstring& save_path,      // output PDF document
+  size_t thread_count,                // max number of threads
+  std::ostream& output                // output stream for the report
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -101,9 +336,66 @@ void ConvertRGBToCMYK(
   if (!doc)
     throw PdfixException();
 
-  gCMYKColorSpace = doc->CreateColorSpace(PdfColorSpaceFamily::kColorSpaceDeviceCMYK);
+  auto num_pages = doc->GetNumPages();
+  std::vector<int> page_counts(num_pages);
+  {
+    CMYKConverter converter(doc);
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+
+    // forms, shadings and functions may be shared by pages, they are converted one page after
+    // another and counted on the first page using them
+    for (int i = 0; i < num_pages; i++) {
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+      page_counts[i] = ConvertSharedObjects(converter, doc, page->GetContent());
+    }
 
-  ConvertRGBToCMYK(doc);
+    // objects of the page content are edited in parallel, content streams are written to the
+    // document one page at a time
+    std::mutex save_mutex;
+    auto convert_pages = [&](int from, int to) {
+      for (int i = from; i <= to; i++) {
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        auto content = page->GetContent();
+        int converted = 0;
+        for (int j = 0; j < content->GetNumObjects(); j++) {
+          if (ConvertObject(converter, content->GetObject(j)))
+            converted++;
+        }
+        page_counts[i] += converted;
+        if (converted > 0) {
+          std::lock_guard<std::mutex> lock(save_mutex);
+          if (!page->SetContent())
+            throw PdfixException();
+        }
+      }
+    };
+    ParallelFor(0, num_pages - 1, thread_count, convert_pages);
+
+    // pages written above may still refer to the original forms
+    std::set<int> visited;
+    for (int i = 0; i < num_pages && !converter.GetForms().empty(); i++) {
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+      PdsDictionary* node = page->GetObject();
+      while (node && !node->Known(L"Resources"))
+        node = node->GetDictionary(L"Parent");
+      if (node)
+        ReplaceForms(node->GetDictionary(L"Resources"), converter.GetForms(), visited);
+    }
+
+    int total = 0;
+    for (int i = 0; i < num_pages; i++) {
+      output << "page " << i + 1 << ": " << page_counts[i] << " objects converted" << std::endl;
+      total += page_counts[i];
+    }
+    output << "total: " << total << " objects, " << converter.GetNumColors() << " distinct colors"
+      << std::endl;
+  }
 
   if (!doc->Save(save_path.c_str(), kSaveFull))
     throw PdfixException();
@@ -111,4 +403,3 @@ void ConvertRGBToCMYK(
   doc->Close();
   pdfix->Destroy();
 }
-
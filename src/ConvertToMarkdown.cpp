@@ -0,0 +1,286 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ConvertToMarkdown.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ConvertToMarkdown.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cwchar>
+#include <cwctype>
+#include "pdfixsdksamples/ConvertToHtml.h"
+#include "pdfixsdksamples/ExtractTables.h"
+#include "pdfixsdksamples/ExtractText.h"
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace ConvertToMarkdown {
+
+  // joins lines of the text element into one line
+  static std::wstring GetSingleLine(const std::wstring& text) {
+    std::wstring line;
+    line.reserve(text.length());
+    for (auto ch : text) {
+      if (ch == L'\r' || ch == L'\n' || ch == L'\t')
+        ch = L' ';
+      if (ch == L' ' && (line.empty() || line.back() == L' '))
+        continue;
+      line += ch;
+    }
+    while (!line.empty() && line.back() == L' ')
+      line.pop_back();
+    return line;
+  }
+
+  // escapes characters which would start a Markdown block at the beginning of a paragraph
+  static void AppendParagraph(const std::wstring& text, std::string& markdown) {
+    if (!text.empty() && wcschr(L"#>-+*|=`", text[0]))
+      markdown += '\\';
+    AppendUtf8(text, markdown);
+  }
+
+  static void AppendElementText(PdeElement* element, std::wstring& text) {
+    if (element->GetType() == kPdeText) {
+      if (!text.empty())
+        text += L' ';
+      text += GetSingleLine(((PdeText*)element)->GetText());
+      return;
+    }
+    for (int i = 0; i < element->GetNumChildren(); i++) {
+      auto child = element->GetChild(i);
+      if (child)
+        AppendElementText(child, text);
+    }
+  }
+
+  static void AppendText(PdeText* text, std::string& markdown) {
+    auto line = GetSingleLine(text->GetText());
+    if (line.empty())
+      return;
+    switch (text->GetTextStyle()) {
+    case kTextTitle:
+    case kTextH1: markdown += "# "; break;
+    case kTextH2: markdown += "## "; break;
+    case kTextH3: markdown += "### "; break;
+    case kTextH4: markdown += "#### "; break;
+    case kTextH5: markdown += "##### "; break;
+    // Markdown has six heading levels
+    case kTextH6:
+    case kTextH7:
+    case kTextH8: markdown += "###### "; break;
+    case kTextNote: markdown += "> "; break;
+    default:
+      AppendParagraph(line, markdown);
+      markdown += "\n\n";
+      return;
+    }
+    AppendUtf8(line, markdown);
+    markdown += "\n\n";
+  }
+
+  static void AppendList(PdeElement* list, std::string& markdown) {
+    for (int i = 0; i < list->GetNumChildren(); i++) {
+      auto child = list->GetChild(i);
+      if (!child)
+        continue;
+      std::wstring item;
+      AppendElementText(child, item);
+      if (item.empty())
+        continue;
+
+      // ordered items keep their label, bullets are replaced with the Markdown marker
+      size_t digits = 0;
+      while (digits < item.length() && iswdigit(item[digits]))
+        digits++;
+      if (digits > 0 && digits < item.length() && (item[digits] == L'.' || item[digits] == L')')) {
+        AppendUtf8(item.substr(0, digits), markdown);
+        markdown += ". ";
+        item = GetSingleLine(item.substr(digits + 1));
+      }
+      else {
+        if (wcschr(L"\x2022\x25E6\x25AA\x25CF\x2013-*", item[0]))
+          item = GetSingleLine(item.substr(1));
+        markdown += "- ";
+      }
+      AppendUtf8(item, markdown);
+      markdown += '\n';
+    }
+    markdown += '\n';
+  }
+
+  static void AppendTableCell(const std::wstring& text, std::string& markdown) {
+    std::wstring cell;
+    for (auto ch : GetSingleLine(text)) {
+      if (ch == L'|')
+        cell += L'\\';
+      cell += ch;
+    }
+    markdown += ' ';
+    AppendUtf8(cell, markdown);
+    markdown += " |";
+  }
+
+  static void AppendTable(PdeTable* table, std::string& markdown) {
+    // Markdown tables have no spans, spanned cells are written once
+    TableData table_data;
+    GetTableData(table, false, table_data);
+    if (table_data.rows.empty() || table_data.rows[0].empty())
+      return;
+
+    bool header = true;
+    for (auto& row : table_data.rows) {
+      markdown += '|';
+      for (auto& cell : row)
+        AppendTableCell(cell, markdown);
+      markdown += '\n';
+      if (header) {
+        markdown += '|';
+        for (size_t i = 0; i < row.size(); i++)
+          markdown += " --- |";
+        markdown += '\n';
+        header = false;
+      }
+    }
+    markdown += '\n';
+  }
+
+  static void AppendElement(PdeElement* element, std::string& markdown) {
+    switch (element->GetType()) {
+    case kPdeHeader:
+    case kPdeFooter:
+    case kPdeImage:
+      return;
+    case kPdeText:
+      AppendText((PdeText*)element, markdown);
+      return;
+    case kPdeList:
+      AppendList(element, markdown);
+      return;
+    case kPdeTable:
+      AppendTable((PdeTable*)element, markdown);
+      return;
+    default:
+      for (int i = 0; i < element->GetNumChildren(); i++) {
+        auto child = element->GetChild(i);
+        if (child)
+          AppendElement(child, markdown);
+      }
+    }
+  }
+
+  void GetPageMarkdown(PdfPage* page, std::string& markdown) {
+    auto page_map_deleter = [](PdePageMap* page_map) { page_map->Release(); };
+    std::unique_ptr<PdePageMap, decltype(page_map_deleter)>
+      page_map(page->AcquirePageMap(), page_map_deleter);
+    if (!page_map)
+      throw PdfixException();
+    if (!page_map->CreateElements(nullptr, nullptr))
+      throw PdfixException();
+    auto element = page_map->GetElement();
+    if (!element)
+      throw PdfixException();
+    AppendElement(element, markdown);
+  }
+
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    std::ostream& output,                 // output stream
+    size_t thread_count,                  // max number of threads
+    FingerprintStore* fingerprint_store   // pages with known fingerprint reuse the stored markdown
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    auto num_pages = doc->GetNumPages();
+    if (thread_count == 0)
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    int workers = (int)std::min<size_t>(thread_count, std::max(num_pages, 0));
+
+    // pages are claimed in order so only few of them wait for their turn in the writer
+    ExtractText::OrderedPageWriter writer(output, 0, "", 1);
+    std::atomic<int> next_page(0);
+    auto convert_pages = [&](int, int) {
+      PageHasher hasher;
+      for (int i = next_page++; i < num_pages; i = next_page++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        std::string markdown;
+        // pages converted before write the stored markdown
+        uint64_t fingerprint = fingerprint_store ? hasher.GetFingerprint(page.get()) : 0;
+        if (!fingerprint_store || !fingerprint_store->Find(fingerprint, markdown)) {
+          GetPageMarkdown(page.get(), markdown);
+          if (fingerprint_store)
+            fingerprint_store->Add(fingerprint, markdown);
+        }
+        writer.Write(i, std::move(markdown));
+      }
+    };
+    ParallelFor(0, workers - 1, workers, convert_pages);
+    if (fingerprint_store)
+      fingerprint_store->Report(std::cout);
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+
+  void Benchmark(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& html_path,        // output HTML file of the ConvertToHtml run
+    std::ostream& output,                 // report stream
+    size_t thread_count                   // max number of threads
+  ) {
+    auto measure = [&](const char* name, const std::function<void()>& convert) {
+      auto start = std::chrono::steady_clock::now();
+      convert();
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      output << name << ": " << seconds << " s" << std::endl;
+      return seconds;
+    };
+
+    // ConvertToHtml runs on one thread, the formats are compared at the same thread count and
+    // the parallel Markdown run is reported separately
+    std::ostringstream markdown;
+    auto single_time = measure("markdown, 1 thread", [&]() {
+      Run(open_path, markdown, 1);
+    });
+    auto html_time = measure("html, 1 thread", [&]() {
+      PdfHtmlParams html_params;
+      ConvertToHtml::Run(open_path, L"", html_path, L"", html_params, false);
+    });
+    std::ostringstream parallel_markdown;
+    std::string name = "markdown, " + std::to_string(thread_count) + " threads";
+    auto parallel_time = measure(name.c_str(), [&]() {
+      Run(open_path, parallel_markdown, thread_count);
+    });
+
+    auto size = markdown.tellp();
+    if (single_time > 0) {
+      output << "markdown throughput: " << size / single_time / 1024 << " KB/s" << std::endl;
+      output << "speedup over html: " << html_time / single_time << "x" << std::endl;
+    }
+    if (parallel_time > 0)
+      output << "speedup of " << thread_count << " threads: " << single_time / parallel_time << "x"
+        << std::endl;
+  }
+} // namespace ConvertToMarkdown
@@ -42,12 +42,14 @@ void CreateNewDocuments(
       if (!doc)
         throw PdfixException();
 
-      PdfRect* mBox = new PdfRect();
-      mBox->left = 0;
-      mBox->right = 595;
-      mBox->bottom = 0;
-      mBox->top = 842;
-      auto page = doc->CreatePage(-1, mBox);
+      PdfRect media_box;
+      media_box.left = 0;
+      media_box.right = 595;
+      media_box.bottom = 0;
+      media_box.top = 842;
+      auto page = doc->CreatePage(-1, &media_box);
+      if (!page)
+        throw PdfixException();
       page->Release();
       if (!doc->Save(ss.str().c_str(), kSaveFull))
         throw PdfixException();
@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// DocumentGenerator.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/DocumentGenerator.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace DocumentGenerator {
+
+  PdfDoc* CreateDocument(
+    Pdfix* pdfix,                                          // pdfix instance
+    const std::vector<EditContent::ObjectProps>& props,    // objects of the page
+    const PdfRect& media_box,                              // page size
+    bool use_cache                                         // share resources in the document
+  ) {
+    auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+    std::unique_ptr<PdfDoc, decltype(doc_deleter)> doc(pdfix->CreateDoc(), doc_deleter);
+    if (!doc)
+      throw PdfixException();
+
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->CreatePage(-1, &media_box), page_deleter);
+    if (!page)
+      throw PdfixException();
+
+    auto content = page->GetContent();
+    if (use_cache) {
+      EditContent::ResourceCache cache(pdfix, doc.get());
+      EditContent::EditPageContent(cache, content, props);
+    }
+    else
+      EditContent::EditPageContent(pdfix, doc.get(), content, props);
+
+    if (!page->SetContent())
+      throw PdfixException();
+    return doc.release();
+  }
+
+  void Generate(
+    const std::wstring& save_dir,         // output directory
+    size_t document_count,                // number of documents to generate
+    const BuildProc& build,               // objects of each document
+    bool use_cache,                       // share resources in each document
+    size_t thread_count,                  // max number of threads
+    Stats& stats                          // generation statistics
+  ) {
+    Pdfix* pdfix = GetPdfix();
+
+    PdfRect media_box;
+    media_box.left = 0;
+    media_box.bottom = 0;
+    media_box.right = 595;
+    media_box.top = 842;
+
+    std::atomic<size_t> object_count(0);
+    auto clock_start = std::chrono::steady_clock::now();
+
+    auto generate_docs = [&](int from, int to) {
+      EditContent::PropsBuilder builder;
+      for (int i = from; i <= to; i++) {
+        builder.Clear();
+        build(i, builder);
+        auto& props = builder.Get();
+
+        auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+        std::unique_ptr<PdfDoc, decltype(doc_deleter)>
+          doc(CreateDocument(pdfix, props, media_box, use_cache), doc_deleter);
+
+        if (save_dir.empty()) {
+          auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+          std::unique_ptr<PsStream, decltype(stm_deleter)> stm(pdfix->CreateMemStream(), stm_deleter);
+          if (!stm)
+            throw PdfixException();
+          if (!doc->SaveToStream(stm.get(), kSaveFull))
+            throw PdfixException();
+        }
+        else {
+          std::wstringstream ss;
+          ss << save_dir << L"/document" << i << L".pdf";
+          if (!doc->Save(ss.str().c_str(), kSaveFull))
+            throw PdfixException();
+        }
+        object_count += props.size();
+      }
+    };
+    ParallelFor(0, (int)document_count - 1, thread_count, generate_docs);
+
+    auto clock_end = std::chrono::steady_clock::now();
+    stats.documents = document_count;
+    stats.objects = object_count;
+    stats.seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+  }
+
+  void BuildInvoice(const std::wstring& logo_path, size_t doc_index, EditContent::PropsBuilder& builder) {
+    const int item_count = 10;
+    builder.Reserve(8 + item_count);
+    builder.AddImage(40, 740, logo_path);
+    builder.AddText(300, 780, L"Invoice " + std::to_wstring(100000 + doc_index));
+    builder.AddText(40, 700, L"Customer " + std::to_wstring(doc_index));
+    builder.AddText(40, 676, L"Street " + std::to_wstring(doc_index % 200 + 1));
+    builder.AddPath(30, 100, L"M 0 0 L 535 0 L 535 560 L 0 560 Z");
+
+    double total = 0;
+    for (int i = 0; i < item_count; i++) {
+      double price = (double)((doc_index * 7 + i * 13) % 1000) / 10 + 1;
+      total += price;
+      std::wstringstream line;
+      line << L"Item " << i + 1 << L"  " << price;
+      builder.AddText(50, 620 - 40 * i, line.str());
+    }
+
+    std::wstringstream total_line;
+    total_line << L"Total  " << total;
+    builder.AddText(50, 140, total_line.str());
+    builder.AddPath(40, 170, L"M 0 0 L 515 0");
+  }
+
+  void Run(
+    const std::wstring& save_dir,         // output directory
+    const std::wstring& logo_path,        // logo image placed on each invoice
+    size_t document_count,                // number of documents to generate
+    size_t thread_count                   // max number of threads
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    auto build = [&](size_t doc_index, EditContent::PropsBuilder& builder) {
+      BuildInvoice(logo_path, doc_index, builder);
+    };
+    Stats stats;
+    Generate(save_dir, document_count, build, true, thread_count, stats);
+
+    pdfix->Destroy();
+  }
+
+  void Benchmark(
+    const std::wstring& logo_path,        // logo image placed on each invoice
+    size_t document_count,                // number of documents to generate
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    auto build = [&](size_t doc_index, EditContent::PropsBuilder& builder) {
+      BuildInvoice(logo_path, doc_index, builder);
+    };
+
+    auto report = [&](const char* name, const Stats& stats) {
+      output << name << ": " << stats.documents << " docs, " << stats.objects << " objects in "
+        << stats.seconds << " s (" << stats.GetDocsPerSecond() << " docs/s)" << std::endl;
+    };
+
+    Stats baseline;
+    Generate(L"", document_count, build, false, 1, baseline);
+    report("per-object resources, 1 thread", baseline);
+
+    Stats cached;
+    Generate(L"", document_count, build, true, 1, cached);
+    report("cached resources, 1 thread", cached);
+
+    Stats parallel;
+    Generate(L"", document_count, build, true, thread_count, parallel);
+    std::string name = "cached resources, " + std::to_string(thread_count) + " threads";
+    report(name.c_str(), parallel);
+
+    if (parallel.seconds > 0)
+      output << "speedup: " << baseline.seconds / parallel.seconds << std::endl;
+
+    pdfix->Destroy();
+  }
+} // namespace DocumentGenerator
@@ -7,46 +7,128 @@
 
 #include "Pdfix.h"
 
-#include <sstream>
-#include <iterator>
+#include <algorithm>
+#include "pdfixsdksamples/SvgPath.h"
 
 using namespace PDFixSDK;
 
 namespace EditContent {
 
-  PropsBuilder& PropsBuilder::AddText(double x, double y, const std::wstring& text) {
+  PropsBuilder& PropsBuilder::Add(double x, double y, PdfPageObjectType obj_type, std::wstring&& data) {
     ObjectProps props;
     props.pos.x = x;
     props.pos.y = y;
-    props.obj_type = PdfPageObjectType::kPdsPageText;
-    props.data = text;
-    m_properties.push_back(props);return *this;
+    props.obj_type = obj_type;
+    props.data = std::move(data);
+    m_properties.push_back(std::move(props));
+    return *this;
   }
 
-  PropsBuilder& PropsBuilder::AddPath(double x, double y, const std::wstring& svg) {
-    ObjectProps props;
-    props.pos.x = x;
-    props.pos.y = y;
-    props.obj_type = PdfPageObjectType::kPdsPagePath;
-    props.data = svg;
-    m_properties.push_back(props);
-    return *this;
+  PropsBuilder& PropsBuilder::AddText(double x, double y, std::wstring text) {
+    return Add(x, y, PdfPageObjectType::kPdsPageText, std::move(text));
   }
 
-  PropsBuilder& PropsBuilder::AddImage(double x, double y, const std::wstring& path) {
-    ObjectProps props;
-    props.pos.x = x;
-    props.pos.y = y;
-    props.obj_type = PdfPageObjectType::kPdsPageImage;
-    props.data = path;
-    m_properties.push_back(props);
+  PropsBuilder& PropsBuilder::AddPath(double x, double y, std::wstring svg) {
+    return Add(x, y, PdfPageObjectType::kPdsPagePath, std::move(svg));
+  }
+
+  PropsBuilder& PropsBuilder::AddImage(double x, double y, std::wstring path) {
+    return Add(x, y, PdfPageObjectType::kPdsPageImage, std::move(path));
+  }
+
+  PropsBuilder& PropsBuilder::Reserve(size_t count) {
+    m_properties.reserve(count);
     return *this;
   }
 
+  void PropsBuilder::Clear() {
+    m_properties.clear();
+  }
+
   std::vector<ObjectProps>& PropsBuilder::Get() {
     return m_properties;
   }
 
+  std::vector<ObjectProps> PropsBuilder::Release() {
+    std::vector<ObjectProps> properties;
+    properties.swap(m_properties);
+    return properties;
+  }
+
+  ResourceCache::ResourceCache(Pdfix* pdfix, PdfDoc* doc) : m_pdfix(pdfix), m_doc(doc) {}
+
+  ResourceCache::~ResourceCache() {
+    for (auto& color : m_colors)
+      color.second->Destroy();
+  }
+
+  PdfFont* ResourceCache::GetFont(const std::wstring& name, int flags) {
+    auto key = std::make_pair(name, flags);
+    auto found = m_fonts.find(key);
+    if (found != m_fonts.end())
+      return found->second;
+
+    auto sys_font = m_pdfix->FindSysFont(name.c_str(), flags, PdfFontCodepage::kFontDefANSICodepage);
+    if (!sys_font)
+      throw PdfixException();
+    auto font = m_doc->CreateFont(sys_font, PdfFontCharset::kFontAnsiCharset, 0);
+    sys_font->Destroy();
+    if (!font)
+      throw PdfixException();
+    m_fonts.emplace(key, font);
+    return font;
+  }
+
+  PdfColorSpace* ResourceCache::GetColorSpace(PdfColorSpaceFamily family) {
+    auto found = m_color_spaces.find(family);
+    if (found != m_color_spaces.end())
+      return found->second;
+    auto color_space = m_doc->CreateColorSpace(family);
+    if (!color_space)
+      throw PdfixException();
+    m_color_spaces.emplace(family, color_space);
+    return color_space;
+  }
+
+  PdfColor* ResourceCache::GetRGBColor(float r, float g, float b) {
+    auto component = [](float value) {
+      return (uint32_t)(std::max(0.f, std::min(value, 1.f)) * 255.f + 0.5f);
+    };
+    uint32_t key = (component(r) << 16) | (component(g) << 8) | component(b);
+    auto found = m_colors.find(key);
+    if (found != m_colors.end())
+      return found->second;
+
+    auto color = GetColorSpace(PdfColorSpaceFamily::kColorSpaceDeviceRGB)->CreateColor();
+    if (!color)
+      throw PdfixException();
+    color->SetValue(0, r);
+    color->SetValue(1, g);
+    color->SetValue(2, b);
+    m_colors.emplace(key, color);
+    return color;
+  }
+
+  PdsStream* ResourceCache::GetImage(const std::wstring& path) {
+    auto found = m_images.find(path);
+    if (found != m_images.end())
+      return found->second;
+
+    auto image_stm = m_pdfix->CreateFileStream(path.c_str(), kPsReadOnly);
+    if (!image_stm)
+      throw PdfixException();
+    PdfImageFormat format = kImageFormatJpg;
+    if ((path.rfind(L".png") != std::wstring::npos)
+      || (path.rfind(L".PNG") != std::wstring::npos))
+      format = kImageFormatPng;
+    auto xobj = m_doc->CreateXObjectFromImage(image_stm, format);
+    image_stm->Destroy();
+    if (!xobj)
+      throw PdfixException();
+    m_images.emplace(path, xobj);
+    return xobj;
+  }
+
   // edit content
   void EditPageContent(Pdfix* pdfix, PdfDoc* doc, PdsContent* content, const std::vector<ObjectProps>& object_props) {
 
@@ -68,9 +150,33 @@ namespace EditContent {
     }
   }
 
+  void EditPageContent(ResourceCache& cache, PdsContent* content, const std::vector<ObjectProps>& object_props) {
+
+    for (auto& object_prop : object_props) {
+      switch (object_prop.obj_type)
+      {
+      case PdfPageObjectType::kPdsPageText:
+        AddText(cache, content, object_prop);
+        break;
+      case PdfPageObjectType::kPdsPagePath:
+        AddPath(cache, content, object_prop);
+        break;
+      case PdfPageObjectType::kPdsPageImage:
+        AddImage(cache, content, object_prop);
+        break;
+      default:
+        throw std::runtime_error("not implemented");
+      }
+    }
+  }
+
   void AddText(Pdfix* pdfix, PdfDoc* doc, PdsContent* content, const ObjectProps& object_prop) {
+    // resources created for this object only
+    ResourceCache cache(pdfix, doc);
+    AddText(cache, content, object_prop);
+  }
 
-    auto rgb_colorspace = doc->CreateColorSpace(PdfColorSpaceFamily::kColorSpaceDeviceRGB);
+  void AddText(ResourceCache& cache, PdsContent* content, const ObjectProps& object_prop) {
 
     auto matrix = PdfMatrix();
     matrix.a = 1;
@@ -80,14 +186,7 @@ namespace EditContent {
     matrix.e = object_prop.pos.x;
     matrix.f = object_prop.pos.y;
 
-    auto sys_font = pdfix->FindSysFont(L"Arial", kFontForceBold, PdfFontCodepage::kFontDefANSICodepage);
-
-    if (!sys_font) {
-      throw PdfixException();
-    }
-
-    auto font = doc->CreateFont(sys_font, PdfFontCharset::kFontAnsiCharset, 0);
-    sys_font->Destroy();
+    auto font = cache.GetFont(L"Arial", kFontForceBold);
 
     auto text_obj = content->AddNewText(-1, font, &matrix);
     if (!text_obj)
@@ -96,15 +195,11 @@ namespace EditContent {
     text_obj->SetText(object_prop.data.c_str());
 
     PdfTextState ts;
-    auto stroke_color = rgb_colorspace->CreateColor();
-    stroke_color->SetValue(0, 1.0f);
-    ts.color_state.stroke_color = stroke_color;
+    ts.color_state.stroke_color = cache.GetRGBColor(1.0f, 0.0f, 0.0f);
     ts.color_state.stroke_opacity = 255;
     ts.color_state.stroke_type = kFillTypeSolid;
 
-    auto fill_color = rgb_colorspace->CreateColor();
-    fill_color->SetValue(1, 1.0f);
-    ts.color_state.fill_color = fill_color;
+    ts.color_state.fill_color = cache.GetRGBColor(0.0f, 1.0f, 0.0f);
     ts.color_state.fill_opacity = 255;
     ts.color_state.fill_type = kFillTypeSolid;
 
@@ -117,60 +212,19 @@ namespace EditContent {
     text_obj->SetTextState(&ts);
   }
 
-  void CreatePathFromSvg(std::wstring svg_path, PdsPath* path_obj) {
-    std::wistringstream iss(svg_path);
-    std::istream_iterator<std::wstring, wchar_t, std::char_traits<wchar_t>> it(iss);
-    auto end = std::istream_iterator<std::wstring, wchar_t, std::char_traits<wchar_t>>();
-    for (;it != end; ++it) {
-      auto token = *it;
-      if (token == L"M") {
-        PdfPoint pt;
-        pt.x = std::stod(*(++it));
-        pt.y = std::stod(*(++it));
-        path_obj->MoveTo(&pt);
-      }else if (token == L"L") {
-        PdfPoint pt;
-        pt.x = std::stod(*(++it));
-        pt.y = std::stod(*(++it));
-        path_obj->LineTo(&pt);
-      } else if (token == L"C") {
-        PdfPoint cp1;
-        cp1.x = std::stod(*(++it));
-        cp1.y = std::stod(*(++it));
-
-        PdfPoint cp2;
-        cp2.x = std::stod(*(++it));
-        cp2.y = std::stod(*(++it));
-
-        PdfPoint pt;
-        pt.x = std::stod(*(++it));
-        pt.y = std::stod(*(++it));
-        path_obj->CurveTo(&cp1, &cp2, &pt);
-      } else if (token == L"A") {
-        PdfPoint r;
-        r.x = std::stod(*(++it));
-        r.y = std::stod(*(++it));
-
-        double x_angle = std::stod(*(++it));
-
-        bool large = std::stoi(*(++it)) != 0;
-        bool sweep = std::stoi(*(++it)) != 0;
-
-        PdfPoint to;
-        to.x = std::stod(*(++it));
-        to.y = std::stod(*(++it));
-
-        path_obj->ArcTo(&to, &r, x_angle, large, sweep);
-      } else if (token == L"Z") {
-        path_obj->ClosePath();
-      }
-    }
+  void CreatePathFromSvg(const std::wstring& svg_path, PdsPath* path_obj) {
+    SvgPath::PdsPathSink sink(path_obj);
+    if (!SvgPath::Parse(svg_path, sink))
+      throw std::runtime_error("Invalid SVG path data");
   }
 
   //path
   void AddPath(PdfDoc* doc, PdsContent* content, const ObjectProps& object_prop) {
+    ResourceCache cache(GetPdfix(), doc);
+    AddPath(cache, content, object_prop);
+  }
 
-    auto rgb_colorspace = doc->CreateColorSpace(PdfColorSpaceFamily::kColorSpaceDeviceRGB);
+  void AddPath(ResourceCache& cache, PdsContent* content, const ObjectProps& object_prop) {
 
     PdfMatrix matrix;
     matrix.a = 1;
@@ -191,21 +245,12 @@ namespace EditContent {
 
     PdfGraphicState gs;
     // stroke blue color
-    auto stroke_color = rgb_colorspace->CreateColor();
-    stroke_color->SetValue(0, 0.2f);
-    stroke_color->SetValue(1, 0.7f);
-    stroke_color->SetValue(2, 0.8f);
-
-    gs.color_state.stroke_color = stroke_color;
+    gs.color_state.stroke_color = cache.GetRGBColor(0.2f, 0.7f, 0.8f);
     gs.color_state.stroke_opacity = 255;
     gs.color_state.stroke_type = kFillTypeSolid;
 
     // fill red color
-    auto fill_color = rgb_colorspace->CreateColor();
-    fill_color->SetValue(0, 0.99f);
-    fill_color->SetValue(1, 0.33f);
-    fill_color->SetValue(2, 0.33f);
-    gs.color_state.fill_color = fill_color;
+    gs.color_state.fill_color = cache.GetRGBColor(0.99f, 0.33f, 0.33f);
     gs.color_state.fill_opacity = 255;
     gs.color_state.fill_type = kFillTypeSolid;
     
@@ -222,15 +267,12 @@ namespace EditContent {
 
   //image
   void AddImage(Pdfix* pdfix, PdfDoc* doc, PdsContent* content, const ObjectProps& object_prop) {
-    auto& img_path = object_prop.data;
-    auto image_stm = pdfix->CreateFileStream(img_path.c_str(), kPsReadOnly);
-    if (!image_stm)
-      throw PdfixException();
-    PdfImageFormat format = kImageFormatJpg;
-    if ((img_path.rfind(L".png") != std::wstring::npos)
-      || (img_path.rfind(L".PNG") != std::wstring::npos))
-      format = kImageFormatPng;
-    auto xobj = doc->CreateXObjectFromImage(image_stm, format);
+    ResourceCache cache(pdfix, doc);
+    AddImage(cache, content, object_prop);
+  }
+
+  void AddImage(ResourceCache& cache, PdsContent* content, const ObjectProps& object_prop) {
+    auto xobj = cache.GetImage(object_prop.data);
     auto image_dict = xobj->GetStreamDict();
     auto width = image_dict->GetNumber(L"Width");
     auto height = image_dict->GetNumber(L"Height");
@@ -242,7 +284,8 @@ namespace EditContent {
     matrix.e = object_prop.pos.x;
     matrix.f = object_prop.pos.y;
     auto image_obj = content->AddNewImage(-1, xobj, &matrix);
-
+    if (!image_obj)
+      throw PdfixException();
   }
 
   ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,14 @@
 
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include "pdfixsdksamples/ImageCache.h"
+#include "pdfixsdksamples/Utils.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
@@ -17,7 +25,8 @@ void SaveImage(PdeElement* element,
   PdfImageParams& img_params,
   PdfPage* page, 
   PdfPageView* page_view, 
-  int& image_index) {
+  int& image_index,
+  ImageCache* image_cache) {
 
   Pdfix* pdfix = GetPdfix();
     
@@ -33,20 +42,30 @@ void SaveImage(PdeElement* element,
     int elem_height = elem_dev_rect.bottom - elem_dev_rect.top;
     if (elem_height == 0 || elem_width == 0)
       return;
-      
-    PsImage* ps_image = pdfix->CreateImage(page_view->GetDeviceWidth(),
-      page_view->GetDeviceHeight(), kImageDIBFormatArgb);
-    if (!ps_image)
-      throw PdfixException();
 
-    PdfPageRenderParams render_params;
-    render_params.image = ps_image;
-    page_view->GetDeviceMatrix(&render_params.matrix);
-    page->DrawContent(&render_params, nullptr, nullptr);
-      
-    std::wstring path = save_path + L"/ExtractImages_" + std::to_wstring(image_index++) + L".png";
-    ps_image->SaveRect(path.c_str(), &img_params, &elem_dev_rect);
-    ps_image->Destroy();
+    // repeated images are saved only once, their children are still processed
+    std::wstring path = save_path + L"/ExtractImages_" + std::to_wstring(image_index) + L".png";
+    std::string first_path;
+    if (image_cache->Lookup(element, ToUtf8(path), first_path)) {
+      std::cout << std::endl << "Image on page " << page->GetNumber() + 1 << " is a repeat of "
+        << first_path;
+    }
+    else {
+      image_index++;
+
+      PsImage* ps_image = pdfix->CreateImage(page_view->GetDeviceWidth(),
+        page_view->GetDeviceHeight(), kImageDIBFormatArgb);
+      if (!ps_image)
+        throw PdfixException();
+
+      PdfPageRenderParams render_params;
+      render_params.image = ps_image;
+      page_view->GetDeviceMatrix(&render_params.matrix);
+      page->DrawContent(&render_params, nullptr, nullptr);
+
+      ps_image->SaveRect(path.c_str(), &img_params, &elem_dev_rect);
+      ps_image->Destroy();
+    }
   }
 
   int count = element->GetNumChildren();
@@ -55,7 +74,7 @@ void SaveImage(PdeElement* element,
   for (int i = 0; i < count; i++) {
     PdeElement* child = element->GetChild(i);
     if (child)
-      SaveImage(child, save_path, img_params, page, page_view, image_index);
+      SaveImage(child, save_path, img_params, page, page_view, image_index, image_cache);
   }
 }
 
@@ -64,7 +83,8 @@ void ExtractImages(
   const std::wstring& open_path,                // source PDF document
   const std::wstring& save_path,                // directory where to extract images
   int render_width,                             // with of the rendered page in pixels (image )
-  PdfImageParams& img_params                    // image parameters
+  PdfImageParams& img_params,                   // image parameters
+  ImageCache* image_cache                       // cache of already extracted images, may be null
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -84,6 +104,10 @@ void ExtractImages(
   img_params.format = kImageFormatPng;
   int image_index = 1;
 
+  ImageCache local_cache;
+  if (!image_cache)
+    image_cache = &local_cache;
+
   auto num_pages = doc->GetNumPages();
 
   for (auto i = 0; i < num_pages; i++) {
@@ -111,12 +135,244 @@ void ExtractImages(
     auto element = page_map->GetElement();
     if (!element)
       throw PdfixException();
-    SaveImage(element, save_path.c_str(), img_params, page, page_view, image_index);
+    SaveImage(element, save_path.c_str(), img_params, page, page_view, image_index, image_cache);
 
     page->Release();
   }
   std::cout << std::endl << image_index - 1 << " images found" << std::endl;
+  image_cache->Report(std::cout);
+
+  image_cache->ReleaseDocument(doc);
+  doc->Close();
+  pdfix->Destroy();
+}
+
+// how the image stream is saved
+enum ImageStreamKind {
+  kImageStreamCopy,       // encoded stream is copied as is
+  kImageStreamDecode,     // decoded samples are saved
+  kImageStreamRender,     // image area is rendered
+};
+
+// returns the last filter applied to the stream data
+static std::wstring GetImageFilter(PdsDictionary* dict) {
+  auto filter = dict->Get(L"Filter");
+  if (!filter)
+    return L"";
+  if (filter->GetObjectType() == kPdsName)
+    return ((PdsName*)filter)->GetText();
+  if (filter->GetObjectType() == kPdsArray) {
+    auto filters = (PdsArray*)filter;
+    auto count = filters->GetNumObjects();
+    if (count > 0)
+      return filters->GetText(count - 1);
+  }
+  return L"";
+}
+
+// returns number of color components of device gray and rgb images, 0 otherwise
+static int GetImageComponents(PdsDictionary* dict) {
+  auto color_space = dict->Get(L"ColorSpace");
+  if (!color_space)
+    return 0;
+  std::wstring family;
+  if (color_space->GetObjectType() == kPdsName)
+    family = ((PdsName*)color_space)->GetText();
+  else if (color_space->GetObjectType() == kPdsArray) {
+    auto cs_array = (PdsArray*)color_space;
+    family = cs_array->GetText(0);
+    if (family == L"ICCBased") {
+      auto icc = cs_array->GetStream(1);
+      auto n = icc ? (int)icc->GetStreamDict()->GetNumber(L"N") : 0;
+      return (n == 1 || n == 3) ? n : 0;
+    }
+  }
+  if (family == L"DeviceGray" || family == L"CalGray")
+    return 1;
+  if (family == L"DeviceRGB" || family == L"CalRGB")
+    return 3;
+  return 0;
+}
+
+static ImageStreamKind GetImageStreamKind(PdsStream* stream) {
+  // inline images are not indirect objects
+  if (!stream || stream->GetId() == 0)
+    return kImageStreamRender;
+  auto dict = stream->GetStreamDict();
+  if (dict->Known(L"SMask") || dict->Known(L"Mask") || dict->GetBoolean(L"ImageMask", false))
+    return kImageStreamRender;
+  auto filter = GetImageFilter(dict);
+  if (filter == L"DCTDecode" || filter == L"JPXDecode")
+    return kImageStreamCopy;
+  if (filter == L"JBIG2Decode" || filter == L"CCITTFaxDecode")
+    return kImageStreamRender;
+  if (dict->GetInteger(L"BitsPerComponent", 0) == 8 && GetImageComponents(dict) != 0)
+    return kImageStreamDecode;
+  return kImageStreamRender;
+}
+
+static void WriteFile(const std::wstring& path, const std::string& header,
+  const std::vector<unsigned char>& data) {
+  std::ofstream ofs(ToUtf8(path), std::ios::binary);
+  if (!ofs)
+    throw std::runtime_error("Failed to create " + ToUtf8(path));
+  ofs.write(header.data(), header.size());
+  ofs.write((const char*)data.data(), data.size());
+}
+
+// reads the stream data, image codecs (DCT, JPX) are not decoded by PdsStream::Read
+static void ReadImageStream(PdsStream* stream, std::vector<unsigned char>& data) {
+  auto size = stream->GetSize();
+  data.resize(size);
+  if (size && !stream->Read(0, data.data(), size))
+    throw PdfixException();
+}
+
+// Extracts image XObjects without rasterizing pages.
+void ExtractImageStreams(
+  const std::wstring& open_path,                // source PDF document
+  const std::wstring& save_path,                // directory where to extract images
+  double render_zoom,                           // zoom used for rendering masked and inline images
+  size_t thread_count,                          // max number of threads
+  ImageCache* image_cache                       // cache of already extracted images, may be null
+) {
+  // initialize Pdfix
+  if (!Pdfix_init(Pdfix_MODULE_NAME))
+    throw std::runtime_error("Pdfix initialization fail");
+
+  Pdfix* pdfix = GetPdfix();
+  if (!pdfix)
+    throw std::runtime_error("GetPdfix fail");
+
+  PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+  if (!doc)
+    throw PdfixException();
+
+  // images already extracted from other pages or documents
+  ImageCache local_cache;
+  if (!image_cache)
+    image_cache = &local_cache;
+  std::atomic<int> copied(0), decoded(0), rendered(0), duplicates(0);
 
+  auto extract_pages = [&](int from, int to) {
+    for (int i = from; i <= to; i++) {
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+
+      auto page_view_deleter = [](PdfPageView* page_view) { page_view->Release(); };
+      std::unique_ptr<PdfPageView, decltype(page_view_deleter)> page_view(nullptr, page_view_deleter);
+      int render_index = 1;
+
+      auto render_image = [&](PdsImage* image) {
+        if (!page_view) {
+          page_view.reset(page->AcquirePageView(render_zoom, kRotate0));
+          if (!page_view)
+            throw PdfixException();
+        }
+        auto bbox = image->GetBBox();
+        PdfDevRect dev_rect;
+        page_view->RectToDevice(&bbox, &dev_rect);
+        if (dev_rect.right == dev_rect.left || dev_rect.bottom == dev_rect.top)
+          return;
+
+        PsImage* ps_image = pdfix->CreateImage(page_view->GetDeviceWidth(),
+          page_view->GetDeviceHeight(), kImageDIBFormatArgb);
+        if (!ps_image)
+          throw PdfixException();
+        PdfPageRenderParams render_params;
+        render_params.image = ps_image;
+        render_params.clip_box = bbox;
+        page_view->GetDeviceMatrix(&render_params.matrix);
+        page->DrawContent(&render_params, nullptr, nullptr);
+
+        PdfImageParams img_params;
+        img_params.format = kImageFormatPng;
+        std::wstring path = save_path + L"/ExtractImageStreams_page" + std::to_wstring(i + 1) +
+          L"_" + std::to_wstring(render_index++) + L".png";
+        ps_image->SaveRect(path.c_str(), &img_params, &dev_rect);
+        ps_image->Destroy();
+        rendered++;
+      };
+
+      auto extract_image = [&](PdsImage* image) {
+        auto stream = image->GetDataStm();
+        auto kind = GetImageStreamKind(stream);
+        if (kind == kImageStreamRender) {
+          render_image(image);
+          return;
+        }
+
+        // the output path and the decoding are known from the dictionary and the decoded size
+        auto dict = stream->GetStreamDict();
+        auto id = stream->GetId();
+        std::wstring path = save_path + L"/ExtractImageStreams_" + std::to_wstring(id);
+        int width = 0, height = 0, components = 0;
+        if (kind == kImageStreamCopy)
+          path += GetImageFilter(dict) == L"DCTDecode" ? L".jpg" : L".jp2";
+        else {
+          width = dict->GetInteger(L"Width", 0);
+          height = dict->GetInteger(L"Height", 0);
+          components = GetImageComponents(dict);
+          if (stream->GetSize() < width * height * components) {
+            render_image(image);
+            return;
+          }
+          path += components == 1 ? L".pgm" : L".ppm";
+        }
+
+        // repeats of an XObject are found by its id, the data is read once and both hashed and
+        // saved otherwise
+        std::vector<unsigned char> data;
+        auto fingerprint = image_cache->FindFingerprint(image);
+        if (!fingerprint) {
+          ReadImageStream(stream, data);
+          fingerprint = image_cache->GetFingerprint(image, data.data(), data.size());
+        }
+        // the path is registered with the final name, the file is written right after
+        std::string first_path;
+        if (image_cache->Lookup(fingerprint, ToUtf8(path), first_path)) {
+          duplicates++;
+          return;
+        }
+        if (data.empty())
+          ReadImageStream(stream, data);
+
+        if (kind == kImageStreamCopy) {
+          WriteFile(path, "", data);
+          copied++;
+        }
+        else {
+          data.resize(width * height * components);
+          std::string header = std::string(components == 1 ? "P5" : "P6") + "\n" +
+            std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+          WriteFile(path, header, data);
+          decoded++;
+        }
+      };
+
+      // walk page content including form XObjects
+      std::function<void(PdsContent*)> process_content = [&](PdsContent* content) {
+        for (int j = 0; j < content->GetNumObjects(); j++) {
+          auto object = content->GetObject(j);
+          if (object->GetObjectType() == kPdsPageImage)
+            extract_image((PdsImage*)object);
+          else if (object->GetObjectType() == kPdsPageForm)
+            process_content(((PdsForm*)object)->GetContent());
+        }
+      };
+      process_content(page->GetContent());
+    }
+  };
+
+  ParallelFor(0, doc->GetNumPages() - 1, thread_count, extract_pages);
+
+  std::cout << "copied: " << copied << ", decoded: " << decoded << ", rendered: " << rendered
+    << ", duplicates: " << duplicates << std::endl;
+  image_cache->Report(std::cout);
+
+  image_cache->ReleaseDocument(doc);
   doc->Close();
   pdfix->Destroy();
-}
\ No newline at end of file
+}
@@ -22,6 +22,8 @@ namespace ExtractData {
   void ExtractImageObject(PdsImage *image, ptree &node, const DataType &data_types) {
     auto page = image->GetPage();
     auto bbox = image->GetBBox();
+    if (ExtractImageRef(image, node, data_types))
+      return;
     RenderPageArea(page, bbox, node, data_types);
   }
 
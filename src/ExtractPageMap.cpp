@@ -60,6 +60,8 @@ namespace ExtractData {
   void ExtractImageElement(PdeImage* image, ptree& node, const DataType& data_types) {
     auto page = image->GetPageMap()->GetPage();
     auto bbox = image->GetBBox();
+    if (ExtractImageRef(image, node, data_types))
+      return;
     RenderPageArea(page, bbox, node, data_types);
   }
 
@@ -7,11 +7,28 @@
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/xml_parser.hpp>
+#include <cstdio>
+#include "pdfixsdksamples/IncrementalExtraction.h"
+#include "pdfixsdksamples/Utils.h"
 // project
 #include "Pdfix.h"
 
 namespace ExtractData {
 
+  uint64_t HashPageOptions(const DataType& data_types, uint64_t hash) {
+    const bool flags[] = {
+      data_types.page_info, data_types.page_map, data_types.page_content, data_types.page_annots,
+      data_types.page_object_info, data_types.extract_text, data_types.extract_text_style,
+      data_types.extract_text_state, data_types.extract_tables, data_types.extract_images,
+      data_types.extract_paths, data_types.extract_bbox, data_types.extract_graphic_state,
+      data_types.image_cache != nullptr };
+    hash = HashBytes(flags, sizeof(flags), hash);
+    hash = HashBytes(&data_types.render_zoom, sizeof(data_types.render_zoom), hash);
+    hash = HashBytes(&data_types.render_rotate, sizeof(data_types.render_rotate), hash);
+    hash = HashBytes(&data_types.image_format, sizeof(data_types.image_format), hash);
+    return hash;
+  }
+
   // extract page-based data
   void ExtractDocumentPages(PdfDoc* doc, ptree& node, const DataType& data_types) {
     ptree pages_node; // node holding the page array
@@ -19,6 +36,7 @@ namespace ExtractData {
     auto from_page = data_types.page_num == -1 ? 0 : data_types.page_num; 
     auto to_page = data_types.page_num == -1 ? doc->GetNumPages() - 1 : data_types.page_num; 
 
+    PageHasher hasher;
     for (auto i = from_page; i <= to_page; i++) {  
       auto page_deleter = [&](PdfPage *page) { page->Release(); };
       auto page = std::unique_ptr<PdfPage, 
@@ -27,9 +45,35 @@ namespace ExtractData {
         throw PdfixException();
       
       ptree page_node; // node holding the page
-      ExtractPageData(page.get(), page_node, data_types);
-      if (page_node.size())
-        pages_node.push_back(std::make_pair("", page_node));
+      uint64_t fingerprint = 0;
+      if (data_types.fingerprint_store) {
+        // pages extracted before with the same options are replayed from the stored data
+        fingerprint = HashPageOptions(data_types, hasher.GetFingerprint(page.get()));
+        std::string result;
+        if (data_types.fingerprint_store->Find(fingerprint, result)) {
+          std::istringstream iss(result);
+          read_json(iss, page_node);
+        }
+        else {
+          ExtractPageData(page.get(), page_node, data_types);
+          std::ostringstream oss;
+          write_json(oss, page_node, false);
+          data_types.fingerprint_store->Add(fingerprint, oss.str());
+        }
+      }
+      else
+        ExtractPageData(page.get(), page_node, data_types);
+      if (!page_node.size())
+        continue;
+
+      // the page number may differ from the page the data was stored for
+      if (data_types.fingerprint_store) {
+        char fingerprint_str[17];
+        snprintf(fingerprint_str, sizeof(fingerprint_str), "%016llx", (unsigned long long)fingerprint);
+        page_node.put("page_num", i);
+        page_node.put("fingerprint", fingerprint_str);
+      }
+      pages_node.push_back(std::make_pair("", page_node));
     }
     if (pages_node.size())
       node.add_child("pages", pages_node);
@@ -118,6 +162,23 @@ namespace ExtractData {
     ptree doc_node;   // node holding the document
     ExtractDocumentData(doc, doc_node, data_types);
 
+    if (data_types.fingerprint_store) {
+      ptree fingerprints_node;
+      fingerprints_node.put("checked", data_types.fingerprint_store->GetNumChecked());
+      fingerprints_node.put("skipped", data_types.fingerprint_store->GetNumSkipped());
+      fingerprints_node.put("skip_rate", data_types.fingerprint_store->GetSkipRate());
+      doc_node.put_child("fingerprints", fingerprints_node);
+    }
+
+    if (data_types.image_cache) {
+      ptree images_node;
+      images_node.put("count", data_types.image_cache->GetNumLookups());
+      images_node.put("duplicates", data_types.image_cache->GetNumHits());
+      images_node.put("dedupe_ratio", data_types.image_cache->GetDedupeRatio());
+      doc_node.put_child("image_cache", images_node);
+      data_types.image_cache->ReleaseDocument(doc);
+    }
+
     doc->Close();
 
     // save data to output
@@ -132,4 +193,53 @@ namespace ExtractData {
         throw std::runtime_error("unknown output format");
       }
   }
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////
+  void RunIncremental(
+    const std::wstring &open_path,
+    const std::wstring &password,
+    const std::wstring &cache_path,
+    std::ostream &output,
+    const DataType &data_types,
+    size_t thread_count)
+  {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), password.c_str());
+    if (!doc)
+      throw PdfixException();
+
+    // image_ref of a cached page would refer to the first occurrence found by another run or
+    // another thread, the images are extracted on each page
+    DataType page_types = data_types;
+    page_types.image_cache = nullptr;
+
+    IncrementalExtraction::Cache cache;
+    cache.Load(cache_path);
+    auto extracted = IncrementalExtraction::ExtractPages(doc, open_path, cache,
+      HashPageOptions(page_types, kHashSeed),
+      [&](PdfPage* page, ptree& node) { ExtractPageData(page, node, page_types); }, thread_count);
+
+    ptree doc_node;   // node holding the document
+    if (data_types.doc_info)
+      ExtractDocumentInfo(doc, doc_node, data_types);
+    ptree pages_node;
+    for (auto& entry : cache.pages)
+      pages_node.push_back(std::make_pair("", entry.data));
+    doc_node.add_child("pages", pages_node);
+    doc_node.put("extracted_pages", extracted);
+
+    doc->Close();
+
+    if (!cache.Save(cache_path))
+      throw std::runtime_error("Failed to save " + ToUtf8(cache_path));
+
+    write_json(output, doc_node);
+  }
 } // namespace ExtractData
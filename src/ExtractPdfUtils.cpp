@@ -4,6 +4,7 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "pdfixsdksamples/ExtractData.h"
+#include <cstdio>
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/xml_parser.hpp>
@@ -136,6 +137,34 @@ namespace ExtractData {
     stm->Destroy();
   }  
 
+  static bool ExtractImageRef(uint64_t fingerprint, ptree& node, const DataType& data_types) {
+    if (!fingerprint)
+      return false;
+    char image_id[17];
+    snprintf(image_id, sizeof(image_id), "%016llx", (unsigned long long)fingerprint);
+    std::string first_id;
+    if (data_types.image_cache->Lookup(fingerprint, image_id, first_id)) {
+      node.put("image_ref", first_id);
+      return true;
+    }
+    node.put("image_id", image_id);
+    return false;
+  }
+
+  // identify the image in the image cache, returns true if the image was already extracted and
+  // only a reference to it was written
+  bool ExtractImageRef(PdsImage* image, ptree& node, const DataType& data_types) {
+    if (!data_types.image_cache || !image)
+      return false;
+    return ExtractImageRef(data_types.image_cache->GetFingerprint(image), node, data_types);
+  }
+
+  bool ExtractImageRef(PdeElement* element, ptree& node, const DataType& data_types) {
+    if (!data_types.image_cache || !element)
+      return false;
+    return ExtractImageRef(data_types.image_cache->GetFingerprint(element), node, data_types);
+  }
+
   std::string EncodeText(const std::wstring& text) {
     // https://www.w3schools.com/html/html_charset.asp
     std::wstring replace[] = {
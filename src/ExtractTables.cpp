@@ -8,88 +8,156 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <algorithm>
 #include "pdfixsdksamples/Utils.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
-// Example how to extract tables from a PDF document and save them to csv format.
-// GetText processes each element recursively. If the element is a text, saves it to the output stream.
-void GetText(PdeText* element, std::ofstream& ofs, bool eof) {
-  PdeText* text_elem = static_cast<PdeText*>(element);
-  std::wstring text = text_elem->GetText();
+CsvWriter::CsvWriter(std::ostream& output, char delimiter, const std::string& line_end, size_t capacity)
+  : m_output(output), m_delimiter(delimiter), m_line_end(line_end), m_capacity(capacity) {
+  m_buffer.reserve(capacity);
+}
 
-  std::string str = ToUtf8(text);
-  ofs << str;
-  if (eof)
-    ofs << std::endl;
+CsvWriter::~CsvWriter() {
+  Flush();
 }
 
-// SaveTable processes each element recursively. 
-// If the element is a table, it saves it to save_path as csv.
-void SaveTable(PdeElement* element, std::wstring save_path, int& table_index) {
-  Pdfix* pdfix = GetPdfix();
+void CsvWriter::WriteField(const std::string& field) {
+  if (!m_row_start)
+    m_buffer += m_delimiter;
+  m_row_start = false;
 
-  PdfElementType elem_type = element->GetType();
-  if (elem_type == kPdeTable) {
-    PdeTable* table = static_cast<PdeTable*>(element);
+  bool quote = field.find_first_of(std::string("\"\r\n") + m_delimiter) != std::string::npos ||
+    (!field.empty() && (field.front() == ' ' || field.back() == ' '));
+  if (!quote)
+    m_buffer += field;
+  else {
+    m_buffer += '"';
+    for (auto ch : field) {
+      if (ch == '"')
+        m_buffer += '"';
+      m_buffer += ch;
+    }
+    m_buffer += '"';
+  }
+}
 
-    auto path = save_path + L"/ExtractTables_" + std::to_wstring(table_index++) + L".csv";
-    std::ofstream ofs;
-    ofs.open(ToUtf8(path));
-
-    int row_count = table->GetNumRows();
-    int col_count = table->GetNumCols();
-
-    for (int row = 0; row < row_count; row++) {
-      for (int col = 0; col < col_count; col++) {
-        PdeCell* cell = (PdeCell*)table->GetCell(row, col);
-        if (!cell)
-          continue;
-
-        int row_span = cell->GetRowSpan();
-        int col_span = cell->GetColSpan();
-
-        int count = cell->GetNumChildren();
-        if ((row_span != 0) && (col_span != 0) && (count > 0)) {
-          ofs << "\"";
-          for (int i = 0; i < count; i++) {
-            PdeElement* child = cell->GetChild(i);
-            if (child && (child->GetType() == kPdeText)) {
-              GetText((PdeText*)child, ofs, false);
-            }
-            if (i < count - 1) {
-              ofs << " ";
-            }
-          }
-          ofs << "\"";
-        }
-
-        if (col < col_count)
-          ofs << ",";
-      }
-      if (row < row_count)
-        ofs << std::endl;
+void CsvWriter::WriteField(const std::wstring& field) {
+  std::string str;
+  AppendUtf8(field, str);
+  WriteField(str);
+}
+
+void CsvWriter::EndRow() {
+  m_buffer += m_line_end;
+  m_row_start = true;
+  if (m_buffer.size() >= m_capacity)
+    Flush();
+}
+
+void CsvWriter::Flush() {
+  if (m_buffer.empty())
+    return;
+  m_output.write(m_buffer.data(), m_buffer.size());
+  m_buffer.clear();
+}
+
+// appends text of all text elements of the cell, words separated by space
+static void GetCellText(PdeElement* element, std::wstring& text) {
+  if (element->GetType() == kPdeText) {
+    if (!text.empty())
+      text += L' ';
+    text += ((PdeText*)element)->GetText();
+    return;
+  }
+  for (int i = 0; i < element->GetNumChildren(); i++) {
+    PdeElement* child = element->GetChild(i);
+    if (child)
+      GetCellText(child, text);
+  }
+}
+
+void GetTableData(PdeTable* table, bool expand_spans, TableData& table_data) {
+  int row_count = table->GetNumRows();
+  int col_count = table->GetNumCols();
+  auto& rows = table_data.rows;
+  rows.assign(row_count, std::vector<std::wstring>(col_count));
+
+  for (int row = 0; row < row_count; row++) {
+    for (int col = 0; col < col_count; col++) {
+      PdeCell* cell = (PdeCell*)table->GetCell(row, col);
+      if (!cell)
+        continue;
+      // cells covered by a spanning cell have zero span
+      int row_span = cell->GetRowSpan();
+      int col_span = cell->GetColSpan();
+      if (row_span == 0 || col_span == 0)
+        continue;
+
+      std::wstring text;
+      GetCellText(cell, text);
+      int row_to = expand_spans ? std::min(row + row_span, row_count) : row + 1;
+      int col_to = expand_spans ? std::min(col + col_span, col_count) : col + 1;
+      for (int r = row; r < row_to; r++)
+        for (int c = col; c < col_to; c++)
+          rows[r][c] = text;
     }
+  }
+}
 
-    ofs.close();
+// collects tables of the element recursively
+static void GetElementTables(PdeElement* element, int page_num, bool expand_spans,
+  std::vector<TableData>& tables) {
+  if (element->GetType() == kPdeTable) {
+    tables.emplace_back();
+    tables.back().page_num = page_num;
+    GetTableData((PdeTable*)element, expand_spans, tables.back());
+    return;
   }
-  else {
-    int count = element->GetNumChildren();
-    if (count == 0)
-      return;
-    for (int i = 0; i < count; i++) {
-      PdeElement* child = element->GetChild(i);
-      if (child)
-        SaveTable(child, save_path, table_index);
+  for (int i = 0; i < element->GetNumChildren(); i++) {
+    PdeElement* child = element->GetChild(i);
+    if (child)
+      GetElementTables(child, page_num, expand_spans, tables);
+  }
+}
+
+void GetPageTables(PdfPage* page, bool expand_spans, std::vector<TableData>& tables) {
+  auto page_map_deleter = [](PdePageMap* page_map) { page_map->Release(); };
+  std::unique_ptr<PdePageMap, decltype(page_map_deleter)>
+    page_map(page->AcquirePageMap(), page_map_deleter);
+  if (!page_map)
+    throw PdfixException();
+  if (!page_map->CreateElements(nullptr, nullptr))
+    throw PdfixException();
+
+  auto element = page_map->GetElement();
+  if (!element)
+    throw PdfixException();
+  GetElementTables(element, page->GetNumber(), expand_spans, tables);
+}
+
+void WriteTable(const TableData& table_data, CsvWriter& writer, bool with_ids) {
+  for (auto& row : table_data.rows) {
+    if (with_ids) {
+      writer.WriteField(std::to_string(table_data.table_index));
+      writer.WriteField(std::to_string(table_data.page_num + 1));
     }
+    for (auto& cell : row)
+      writer.WriteField(cell);
+    writer.EndRow();
   }
 }
 
 // Extracts all tables from the document and saves them to CSV format. 
 void ExtractTables(
   const std::wstring& open_path,                 // source PDF document
-  const std::wstring& save_path                  // directory where to extract images
+  const std::wstring& save_path,                 // directory where to extract images
+  char delimiter,                                // ',' for CSV, '\t' for TSV
+  bool single_stream,                            // write all tables into one file
+  bool expand_spans,                             // repeat spanned cells in all covered positions
+  size_t thread_count                            // max number of threads
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -103,29 +171,52 @@ void ExtractTables(
   if (!doc)
     throw PdfixException();
 
-  int table_index = 1;
-
   auto num_pages = doc->GetNumPages();
-  for (auto i = 0; i < num_pages; i++) {
-    PdfPage* page = doc->AcquirePage(i);
-    if (!page)
-      throw PdfixException();
-    PdePageMap* page_map = page->AcquirePageMap();
-    if (!page_map)
-      throw PdfixException();
-    if (!page_map->CreateElements(nullptr, nullptr))
-      throw PdfixException();
-
-    auto element = page_map->GetElement();
-    if (!element)
-      throw PdfixException();
-
-    SaveTable(element, save_path, table_index);
-
-    page->Release();
+  std::vector<std::vector<TableData>> page_tables(num_pages);
+  auto extract_pages = [&](int from, int to) {
+    for (int i = from; i <= to; i++) {
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+      GetPageTables(page.get(), expand_spans, page_tables[i]);
+    }
+  };
+  ParallelFor(0, num_pages - 1, thread_count, extract_pages);
+
+  // tables are numbered in page order
+  int table_index = 1;
+  for (auto& tables : page_tables)
+    for (auto& table : tables)
+      table.table_index = table_index++;
+
+  std::wstring ext = delimiter == '\t' ? L".tsv" : L".csv";
+  auto open_file = [&](std::ofstream& ofs, const std::wstring& path) {
+    ofs.open(ToUtf8(path), std::ios::binary);
+    if (!ofs)
+      throw std::runtime_error("Failed to create " + ToUtf8(path));
+  };
+
+  if (single_stream) {
+    std::ofstream ofs;
+    open_file(ofs, save_path + L"/ExtractTables" + ext);
+    CsvWriter writer(ofs, delimiter);
+    for (auto& tables : page_tables)
+      for (auto& table : tables)
+        WriteTable(table, writer, true);
+  }
+  else {
+    for (auto& tables : page_tables) {
+      for (auto& table : tables) {
+        std::ofstream ofs;
+        open_file(ofs, save_path + L"/ExtractTables_" + std::to_wstring(table.table_index) + ext);
+        CsvWriter writer(ofs, delimiter);
+        WriteTable(table, writer, false);
+      }
+    }
   }
   std::cout << std::endl << table_index - 1 << " tables found" << std::endl;
 
   doc->Close();
   pdfix->Destroy();
-}
\ No newline at end of file
+}
@@ -10,12 +10,18 @@
 #include <sstream>
 #include <memory>
 #include <algorithm>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include "pdfixsdksamples/Utils.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
-extern std::string ToUtf8(const std::wstring& wstr);
-
 namespace ExtractText {
   auto doc_deleter = [](PdfDoc*doc){if (doc) doc->Close();};
   auto page_deleter = [](PdfPage*page){if (page) page->Release();};
@@ -60,12 +66,150 @@ namespace ExtractText {
     GetText(container, ss);
   }
 
+  // state of the line grouping while walking the content
+  struct LineState {
+    bool empty = true;
+    PdfRect bbox;                 // bbox of the last text object
+  };
+
+  static void AppendTextObject(PdsText* text_object, bool group_lines, LineState& line,
+    std::string& text) {
+    auto str = ToUtf8(text_object->GetText());
+    if (str.empty())
+      return;
+    auto bbox = text_object->GetBBox();
+    if (!group_lines) {
+      text += str;
+      text += '\n';
+      return;
+    }
+
+    if (!line.empty) {
+      // same line if vertical centers are closer than half of the text height
+      auto height = std::max(bbox.top - bbox.bottom, line.bbox.top - line.bbox.bottom);
+      auto center = (bbox.top + bbox.bottom) / 2;
+      auto line_center = (line.bbox.top + line.bbox.bottom) / 2;
+      if (std::fabs(center - line_center) < height / 2 && bbox.left >= line.bbox.left) {
+        // objects split inside a word follow each other without a gap
+        if (bbox.left - line.bbox.right > height * 0.15)
+          text += ' ';
+      }
+      else
+        text += '\n';
+    }
+    text += str;
+    line.empty = false;
+    line.bbox = bbox;
+  }
+
+  static void GetContentText(PdsContent* content, bool group_lines, LineState& line,
+    std::string& text) {
+    for (int i = 0; i < content->GetNumObjects(); i++) {
+      auto object = content->GetObject(i);
+      if (!object)
+        continue;
+      switch (object->GetObjectType()) {
+      case kPdsPageText:
+        AppendTextObject((PdsText*)object, group_lines, line, text);
+        break;
+      case kPdsPageForm:
+        GetContentText(((PdsForm*)object)->GetContent(), group_lines, line, text);
+        break;
+      default:;
+      }
+    }
+  }
+
+  void GetContentText(PdsContent* content, bool group_lines, std::string& text) {
+    LineState line;
+    GetContentText(content, group_lines, line, text);
+    if (group_lines && !line.empty)
+      text += '\n';
+  }
+
+  void GetPageContentText(PdfPage* page, bool group_lines, std::string& text) {
+    auto content = page->GetContent();
+    if (!content)
+      throw PdfixException();
+    GetContentText(content, group_lines, text);
+  }
+
+  OrderedPageWriter::OrderedPageWriter(std::ostream& output, int first_page,
+    const std::string& separator, int flush_pages)
+    : m_output(output), m_separator(separator), m_flush_pages(flush_pages), m_next_page(first_page) {
+  }
+
+  void OrderedPageWriter::WritePage(int page_num, const std::string& text) {
+    if (m_written > 0 && !m_separator.empty()) {
+      // {page} in the separator is replaced with the number of the following page
+      auto separator = m_separator;
+      auto pos = separator.find("{page}");
+      if (pos != std::string::npos)
+        separator.replace(pos, 6, std::to_string(page_num + 1));
+      m_output << separator;
+    }
+    m_output << text;
+    m_written++;
+    if (m_flush_pages > 0 && m_written % m_flush_pages == 0)
+      m_output.flush();
+  }
+
+  void OrderedPageWriter::Write(int page_num, std::string&& text) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (page_num != m_next_page) {
+      m_pending.emplace(page_num, std::move(text));
+      return;
+    }
+    WritePage(page_num, text);
+    m_next_page++;
+    // write pages which were waiting for this one
+    auto it = m_pending.begin();
+    while (it != m_pending.end() && it->first == m_next_page) {
+      WritePage(it->first, it->second);
+      it = m_pending.erase(it);
+      m_next_page++;
+    }
+  }
+
+  // extracts text of pages [from_page, to_page] using the selected method and passes it to
+  // process_page, pages are claimed in ascending order so only few of them finish out of order
+  static void ExtractPages(PdfDoc* doc, int from_page, int to_page, bool use_page_map,
+    bool group_lines, size_t thread_count,
+    const std::function<void(int, std::string&&)>& process_page) {
+    if (thread_count == 0)
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    int workers = (int)std::min<size_t>(thread_count, std::max(0, to_page - from_page + 1));
+
+    std::atomic<int> next_page(from_page);
+    auto extract_pages = [&](int, int) {
+      for (int i = next_page++; i <= to_page; i = next_page++) {
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        std::string text;
+        if (use_page_map) {
+          std::stringstream ss;
+          GetPageText(page.get(), ss);
+          text = ss.str();
+        }
+        else
+          GetPageContentText(page.get(), group_lines, text);
+        process_page(i, std::move(text));
+      }
+    };
+    // one range per worker, the pages are distributed by next_page
+    ParallelFor(0, workers - 1, workers, extract_pages);
+  }
+
   // Extracts texts from the document and saves them to TXT format.
   void Run(
     const std::wstring& open_path,      // source PDF document
     std::ostream& output,                // output stream
     const std::wstring& config_path,     // configuration file
-    const int page_number
+    const int page_number,               // page to process, -1 for all pages
+    const std::string& page_separator,   // text written between pages, {page} is the page number
+    int flush_pages,                     // flush the output every flush_pages pages, 0 to not flush
+    size_t thread_count                  // max number of threads
     ) {
     // initialize Pdfix
     if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -79,24 +223,143 @@ namespace ExtractText {
     if (!doc)
       throw PdfixException();
 
-    std::stringstream ss;
+    auto num_pages = doc->GetNumPages();
+    auto from_page = page_number == -1 ? 0 : page_number;
+    auto to_page = page_number == -1 ? num_pages - 1 : page_number;
+
+    // write text to stream page by page
+    OrderedPageWriter writer(output, from_page, page_separator, flush_pages);
+    ExtractPages(doc, from_page, to_page, true, false, thread_count,
+      [&](int page_num, std::string&& text) { writer.Write(page_num, std::move(text)); });
+    output.flush();
+
+    // destroy variables
+    doc->Close();
+    pdfix->Destroy();
+  }
+
+  // Extracts text from page content without layout analysis and saves it to TXT format.
+  void RunFast(
+    const std::wstring& open_path,       // source PDF document
+    std::ostream& output,                // output stream
+    const int page_number,               // page to process, -1 for all pages
+    bool group_lines,                    // join text objects on the same line
+    const std::string& page_separator,   // text written between pages, {page} is the page number
+    int flush_pages,                     // flush the output every flush_pages pages, 0 to not flush
+    size_t thread_count                  // max number of threads
+    ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
 
     auto num_pages = doc->GetNumPages();
     auto from_page = page_number == -1 ? 0 : page_number;
     auto to_page = page_number == -1 ? num_pages - 1 : page_number;
-    
-    for (auto i = from_page; i <= to_page; i++) {
-      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
-      if (!page)
+
+    // write text to stream in page order
+    OrderedPageWriter writer(output, from_page, page_separator, flush_pages);
+    ExtractPages(doc, from_page, to_page, false, group_lines, thread_count,
+      [&](int page_num, std::string&& text) { writer.Write(page_num, std::move(text)); });
+    output.flush();
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+
+  // counts occurrences of whitespace separated words
+  static void CountWords(const std::vector<std::string>& page_texts,
+    std::unordered_map<std::string, int>& words) {
+    for (auto& text : page_texts) {
+      std::istringstream iss(text);
+      std::string word;
+      while (iss >> word)
+        words[word]++;
+    }
+  }
+
+  void Benchmark(
+    const std::wstring& open_path,       // source PDF document
+    std::ostream& output,                // report stream
+    size_t thread_count                  // max number of threads
+    ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    // each run works on a freshly opened document so that neither method profits from pages
+    // parsed by the other one, the order of the methods alternates between runs
+    const int run_count = 3;
+    int num_pages = 0;
+    auto measure = [&](bool use_page_map, std::vector<std::string>& page_texts) {
+      auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+      std::unique_ptr<PdfDoc, decltype(doc_deleter)>
+        doc(pdfix->OpenDoc(open_path.c_str(), L""), doc_deleter);
+      if (!doc)
         throw PdfixException();
-      GetPageText(page.get(), ss);
+      num_pages = doc->GetNumPages();
+
+      auto start = std::chrono::steady_clock::now();
+      page_texts.assign(num_pages, std::string());
+      ExtractPages(doc.get(), 0, num_pages - 1, use_page_map, true, thread_count,
+        [&](int page_num, std::string&& text) { page_texts[page_num] = std::move(text); });
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<std::string> page_map_texts, content_texts;
+    std::vector<double> page_map_times, content_times;
+    for (int run = 0; run < run_count; run++) {
+      if (run % 2 == 0) {
+        page_map_times.push_back(measure(true, page_map_texts));
+        content_times.push_back(measure(false, content_texts));
+      }
+      else {
+        content_times.push_back(measure(false, content_texts));
+        page_map_times.push_back(measure(true, page_map_texts));
+      }
     }
 
-    // write text to stream
-    output << ss.str();
+    auto report = [&](const char* name, std::vector<double>& times) {
+      std::sort(times.begin(), times.end());
+      double seconds = times[times.size() / 2];
+      output << name << ": " << num_pages << " pages in " << seconds << " s";
+      if (seconds > 0)
+        output << " (" << num_pages / seconds << " pages/s)";
+      output << ", median of " << times.size() << " runs" << std::endl;
+      return seconds;
+    };
+    auto page_map_time = report("page map", page_map_times);
+    auto content_time = report("content", content_times);
+    if (content_time > 0)
+      output << "speedup: " << page_map_time / content_time << "x" << std::endl;
+
+    // compare outputs by words, the order and line breaks differ between the methods
+    std::unordered_map<std::string, int> page_map_words, content_words;
+    CountWords(page_map_texts, page_map_words);
+    CountWords(content_texts, content_words);
+    size_t total = 0, common = 0;
+    for (auto& word : page_map_words) {
+      total += word.second;
+      auto found = content_words.find(word.first);
+      if (found != content_words.end())
+        common += std::min(word.second, found->second);
+    }
+    output << "words: " << total << " (page map), common with content: " << common;
+    if (total > 0)
+      output << " (" << 100. * common / total << "%)";
+    output << std::endl;
 
-    // destroy variables
-    doc->Close();
     pdfix->Destroy();
   }
-}
\ No newline at end of file
+}
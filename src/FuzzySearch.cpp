@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FuzzySearch.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/FuzzySearch.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace FuzzySearch {
+
+  // end position of an approximate match and its edit distance
+  struct MatchEnd {
+    int end;
+    int distance;
+  };
+
+  // Myers' bit-vector algorithm, reports every text position where a match with at most
+  // max_distance edits ends. The query must not be longer than 64 characters.
+  static void FindEndsBitParallel(const std::wstring& text, const std::wstring& query,
+    int max_distance, std::vector<MatchEnd>& ends) {
+    const int m = (int)query.length();
+    const uint64_t high_bit = uint64_t(1) << (m - 1);
+
+    // pattern match vectors, direct table for latin characters
+    uint64_t peq_latin[256] = { 0 };
+    std::unordered_map<wchar_t, uint64_t> peq_other;
+    for (int i = 0; i < m; i++) {
+      auto ch = query[i];
+      if (ch < 256)
+        peq_latin[ch] |= uint64_t(1) << i;
+      else
+        peq_other[ch] |= uint64_t(1) << i;
+    }
+    auto peq = [&](wchar_t ch) -> uint64_t {
+      if (ch < 256)
+        return peq_latin[ch];
+      auto found = peq_other.find(ch);
+      return found == peq_other.end() ? 0 : found->second;
+    };
+
+    uint64_t pv = ~uint64_t(0);
+    uint64_t mv = 0;
+    int score = m;
+    for (int j = 0; j < (int)text.length(); j++) {
+      uint64_t eq = peq(text[j]);
+      uint64_t xv = eq | mv;
+      uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+      uint64_t ph = mv | ~(xh | pv);
+      uint64_t mh = pv & xh;
+      if (ph & high_bit)
+        score++;
+      else if (mh & high_bit)
+        score--;
+      ph <<= 1;
+      mh <<= 1;
+      pv = mh | ~(xv | ph);
+      mv = ph & xv;
+      if (score <= max_distance)
+        ends.push_back({ j, score });
+    }
+  }
+
+  // Sellers' dynamic programming, same result as FindEndsBitParallel for any query length
+  static void FindEndsDynamic(const std::wstring& text, const std::wstring& query,
+    int max_distance, std::vector<MatchEnd>& ends) {
+    const int m = (int)query.length();
+    std::vector<int> column(m + 1);
+    for (int i = 0; i <= m; i++)
+      column[i] = i;
+    for (int j = 0; j < (int)text.length(); j++) {
+      int diagonal = column[0];  // a match may start at any text position
+      for (int i = 1; i <= m; i++) {
+        int up = column[i];
+        column[i] = std::min({ up + 1, column[i - 1] + 1,
+          diagonal + (query[i - 1] == text[j] ? 0 : 1) });
+        diagonal = up;
+      }
+      if (column[m] <= max_distance)
+        ends.push_back({ j, column[m] });
+    }
+  }
+
+  // finds start of the best alignment of the whole query ending at the text position end
+  static int FindStart(const std::wstring& text, const std::wstring& query, int end, int max_distance) {
+    const int m = (int)query.length();
+    const int max_len = std::min(end + 1, m + max_distance);
+    // align reversed query against text read backwards from the end position
+    std::vector<int> column(max_len + 1);
+    for (int l = 0; l <= max_len; l++)
+      column[l] = l;
+    for (int i = 1; i <= m; i++) {
+      int diagonal = column[0];
+      column[0] = i;
+      for (int l = 1; l <= max_len; l++) {
+        int left = column[l];
+        column[l] = std::min({ left + 1, column[l - 1] + 1,
+          diagonal + (query[m - i] == text[end - l + 1] ? 0 : 1) });
+        diagonal = left;
+      }
+    }
+    int best_len = 1;
+    for (int l = 1; l <= max_len; l++) {
+      if (column[l] < column[best_len])
+        best_len = l;
+    }
+    return end - best_len + 1;
+  }
+
+  void FindApproximate(
+    const PhraseSearch::TextStream& stream,   // normalized page text
+    const std::wstring& query,                // text to search
+    int max_distance,                         // max allowed number of edits
+    int page_num,                             // page number reported in hits
+    std::vector<Hit>& hits                    // found hits
+  ) {
+    auto folded_query = PhraseSearch::NormalizeText(query, true);
+    const int m = (int)folded_query.length();
+    if (m == 0)
+      return;
+    max_distance = std::max(0, std::min(max_distance, m - 1));
+
+    std::vector<MatchEnd> ends;
+    if (m <= 64)
+      FindEndsBitParallel(stream.folded, folded_query, max_distance, ends);
+    else
+      FindEndsDynamic(stream.folded, folded_query, max_distance, ends);
+
+    // consecutive end positions belong to the same occurrence, keep the best one
+    for (size_t i = 0; i < ends.size();) {
+      size_t best = i;
+      size_t next = i + 1;
+      while (next < ends.size() && ends[next].end == ends[next - 1].end + 1) {
+        if (ends[next].distance < ends[best].distance)
+          best = next;
+        next++;
+      }
+
+      auto end = ends[best].end;
+      auto start = FindStart(stream.folded, folded_query, end, max_distance);
+
+      Hit hit;
+      hit.page_num = page_num;
+      hit.distance = ends[best].distance;
+      hit.score = 1. - (double)hit.distance / m;
+      hit.text = stream.text.substr(start, end - start + 1);
+      PhraseSearch::GetRangeQuads(stream, start, end - start + 1, hit.quads);
+      hits.push_back(hit);
+
+      i = next;
+    }
+  }
+
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& query,            // text to search
+    int max_distance,                     // max allowed number of edits
+    std::ostream& output,                 // output stream
+    size_t thread_count                   // max number of threads
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    auto num_pages = doc->GetNumPages();
+    std::vector<std::vector<Hit>> page_hits(num_pages);
+    auto search_pages = [&](int from, int to) {
+      for (int i = from; i <= to; i++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        PhraseSearch::TextStream stream;
+        PhraseSearch::BuildTextStream(page.get(), stream);
+        FindApproximate(stream, query, max_distance, i, page_hits[i]);
+      }
+    };
+    ParallelFor(0, num_pages - 1, thread_count, search_pages);
+
+    std::vector<Hit> hits;
+    for (auto& page : page_hits)
+      hits.insert(hits.end(), page.begin(), page.end());
+    std::stable_sort(hits.begin(), hits.end(),
+      [](const Hit& l, const Hit& r) { return l.score > r.score; });
+
+    for (auto& hit : hits) {
+      output << "page " << hit.page_num + 1 << " score " << hit.score << ": "
+        << ToUtf8(hit.text) << std::endl;
+    }
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+} // namespace FuzzySearch
@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ImageCache.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ImageCache.h"
+
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+std::string WriteImageText(const std::vector<ImageText>& text) {
+  std::ostringstream oss;
+  oss.precision(6);
+  for (auto& item : text) {
+    auto utf8 = ToUtf8(item.text);
+    std::replace(utf8.begin(), utf8.end(), '\n', ' ');
+    std::replace(utf8.begin(), utf8.end(), '\r', ' ');
+    oss << item.rect.left << ' ' << item.rect.bottom << ' ' << item.rect.right << ' '
+      << item.rect.top << ' ' << utf8 << '\n';
+  }
+  return oss.str();
+}
+
+bool ReadImageText(const std::string& data, std::vector<ImageText>& text) {
+  std::istringstream iss(data);
+  std::string line;
+  while (std::getline(iss, line)) {
+    std::istringstream line_stream(line);
+    ImageText item;
+    if (!(line_stream >> item.rect.left >> item.rect.bottom >> item.rect.right >> item.rect.top))
+      return false;
+    line_stream.get();
+    std::string utf8;
+    std::getline(line_stream, utf8);
+    item.text = FromUtf8(utf8);
+    text.push_back(item);
+  }
+  return true;
+}
+
+// hash of the image data and its dimensions
+uint64_t ImageCache::HashImageData(PdsStream* stream, const uint8_t* data, size_t size) {
+  if (size == 0)
+    return 0;
+  uint64_t hash = kHashSeed;
+  auto dict = stream->GetStreamDict();
+  for (auto key : { L"Width", L"Height", L"BitsPerComponent" }) {
+    int32_t value = dict->GetInteger(key, 0);
+    hash = HashBytes(&value, sizeof(value), hash);
+  }
+  hash = HashBytes(data, size, hash);
+  // 0 is reserved for images without a fingerprint
+  return hash ? hash : 1;
+}
+
+uint64_t ImageCache::HashImageData(PdsStream* stream) {
+  auto size = stream->GetSize();
+  if (size <= 0)
+    return 0;
+  std::vector<uint8_t> data(size);
+  if (!stream->Read(0, data.data(), size))
+    return 0;
+  return HashImageData(stream, data.data(), data.size());
+}
+
+uint64_t ImageCache::GetFingerprint(PdsImage* image) {
+  auto stream = image->GetDataStm();
+  if (!stream)
+    return 0;
+  // inline images have no object id and are always hashed
+  auto id = stream->GetId();
+  if (id == 0)
+    return HashImageData(stream);
+
+  auto key = std::make_pair(image->GetPage()->GetDoc(), id);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_object_fingerprints.find(key);
+    if (found != m_object_fingerprints.end())
+      return found->second;
+  }
+  // hash outside the lock, concurrent workers may hash the same XObject once each
+  auto fingerprint = HashImageData(stream);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_object_fingerprints[key] = fingerprint;
+  return fingerprint;
+}
+
+uint64_t ImageCache::FindFingerprint(PdsImage* image) {
+  auto stream = image->GetDataStm();
+  if (!stream || stream->GetId() == 0)
+    return 0;
+  auto key = std::make_pair(image->GetPage()->GetDoc(), stream->GetId());
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_object_fingerprints.find(key);
+  return found != m_object_fingerprints.end() ? found->second : 0;
+}
+
+uint64_t ImageCache::GetFingerprint(PdsImage* image, const uint8_t* data, size_t size) {
+  auto fingerprint = FindFingerprint(image);
+  if (fingerprint)
+    return fingerprint;
+  auto stream = image->GetDataStm();
+  if (!stream)
+    return 0;
+  fingerprint = HashImageData(stream, data, size);
+  auto id = stream->GetId();
+  if (id != 0) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_object_fingerprints[std::make_pair(image->GetPage()->GetDoc(), id)] = fingerprint;
+  }
+  return fingerprint;
+}
+
+uint64_t ImageCache::GetFingerprint(PdeElement* element) {
+  // composite images are made of several image objects, all of them are hashed in order
+  uint64_t hash = kHashSeed;
+  int count = 0;
+  for (int i = 0; i < element->GetNumPageObjects(); i++) {
+    auto object = element->GetPageObject(i);
+    if (!object || object->GetObjectType() != kPdsPageImage)
+      continue;
+    auto fingerprint = GetFingerprint((PdsImage*)object);
+    if (!fingerprint)
+      return 0;
+    hash = HashBytes(&fingerprint, sizeof(fingerprint), hash);
+    count++;
+  }
+  if (count == 0)
+    return 0;
+  return hash ? hash : 1;
+}
+
+bool ImageCache::Lookup(uint64_t fingerprint, const std::string& ref, std::string& first_ref) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_lookups++;
+  if (fingerprint == 0)
+    return false;
+  auto inserted = m_refs.emplace(fingerprint, ref);
+  if (inserted.second)
+    return false;
+  m_hits++;
+  first_ref = inserted.first->second;
+  return true;
+}
+
+bool ImageCache::Lookup(PdsImage* image, const std::string& ref, std::string& first_ref) {
+  return Lookup(GetFingerprint(image), ref, first_ref);
+}
+
+bool ImageCache::Lookup(PdeElement* element, const std::string& ref, std::string& first_ref) {
+  return Lookup(GetFingerprint(element), ref, first_ref);
+}
+
+void ImageCache::SetText(uint64_t fingerprint, std::vector<ImageText> text) {
+  if (fingerprint == 0)
+    return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_texts[fingerprint] = std::move(text);
+}
+
+bool ImageCache::GetText(uint64_t fingerprint, std::vector<ImageText>& text) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_texts.find(fingerprint);
+  if (found == m_texts.end())
+    return false;
+  text = found->second;
+  return true;
+}
+
+void ImageCache::ReleaseDocument(PdfDoc* doc) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto from = m_object_fingerprints.lower_bound(std::make_pair(doc, 0));
+  auto to = from;
+  while (to != m_object_fingerprints.end() && to->first.first == doc)
+    to++;
+  m_object_fingerprints.erase(from, to);
+}
+
+size_t ImageCache::GetNumLookups() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_lookups;
+}
+
+size_t ImageCache::GetNumHits() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_hits;
+}
+
+double ImageCache::GetDedupeRatio() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto unique = m_lookups - m_hits;
+  return unique ? (double)m_lookups / unique : 1.;
+}
+
+void ImageCache::Report(std::ostream& output) {
+  auto lookups = GetNumLookups();
+  auto hits = GetNumHits();
+  output << "images: " << lookups << ", unique: " << lookups - hits
+    << ", dedupe ratio: " << GetDedupeRatio() << std::endl;
+}
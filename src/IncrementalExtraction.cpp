@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// IncrementalExtraction.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/IncrementalExtraction.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <boost/property_tree/json_parser.hpp>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace IncrementalExtraction {
+
+  bool Cache::Load(const std::wstring& path) {
+    std::ifstream ifs(ToUtf8(path));
+    if (!ifs)
+      return false;
+    ptree root;
+    read_json(ifs, root);
+    file_size = root.get<uint64_t>("file_size", 0);
+    tail_hash = std::stoull(root.get<std::string>("tail_hash", "0"), nullptr, 16);
+    options = std::stoull(root.get<std::string>("options", "0"), nullptr, 16);
+    pages.clear();
+    for (auto& page_node : root.get_child("pages", ptree())) {
+      PageEntry entry;
+      entry.page_id = page_node.second.get<int>("page_id", 0);
+      std::istringstream deps(page_node.second.get<std::string>("deps", ""));
+      int id;
+      while (deps >> id)
+        entry.deps.push_back(id);
+      entry.data = page_node.second.get_child("data", ptree());
+      pages.push_back(std::move(entry));
+    }
+    return true;
+  }
+
+  bool Cache::Save(const std::wstring& path) const {
+    std::ofstream ofs(ToUtf8(path));
+    if (!ofs)
+      return false;
+    ptree root;
+    root.put("file_size", file_size);
+    std::ostringstream hash;
+    hash << std::hex << tail_hash;
+    root.put("tail_hash", hash.str());
+    std::ostringstream options_hash;
+    options_hash << std::hex << options;
+    root.put("options", options_hash.str());
+    ptree pages_node;
+    for (auto& entry : pages) {
+      ptree page_node;
+      page_node.put("page_id", entry.page_id);
+      std::ostringstream deps;
+      for (auto id : entry.deps)
+        deps << id << ' ';
+      page_node.put("deps", deps.str());
+      page_node.put_child("data", entry.data);
+      pages_node.push_back(std::make_pair("", page_node));
+    }
+    root.put_child("pages", pages_node);
+    write_json(ofs, root, false);
+    return (bool)ofs;
+  }
+
+  uint64_t GetTailHash(const std::wstring& path, uint64_t size) {
+    std::ifstream ifs(ToUtf8(path), std::ios::binary);
+    if (!ifs)
+      return 0;
+    uint64_t from = size > 4096 ? size - 4096 : 0;
+    std::string data((size_t)(size - from), '\0');
+    ifs.seekg(from);
+    if (!ifs.read(&data[0], data.size()))
+      return 0;
+    return HashBytes(data.data(), data.size());
+  }
+
+  // parses "N G obj" headers in the data
+  static void FindObjectHeaders(const std::string& data, std::vector<int>& ids) {
+    size_t pos = 0;
+    while ((pos = data.find("obj", pos)) != std::string::npos) {
+      size_t end = pos;
+      pos += 3;
+      // "endobj" and "obj" followed by a regular character are not headers
+      if (end >= 3 && data.compare(end - 3, 3, "end") == 0)
+        continue;
+      if (pos < data.size() && isalnum((unsigned char)data[pos]))
+        continue;
+      // generation number and object number separated by whitespace
+      size_t i = end;
+      auto skip_space = [&]() {
+        size_t from = i;
+        while (i > 0 && isspace((unsigned char)data[i - 1]))
+          i--;
+        return i < from;
+      };
+      auto read_number = [&](int& value) {
+        size_t last = i;
+        while (i > 0 && isdigit((unsigned char)data[i - 1]))
+          i--;
+        if (i == last || last - i > 10)
+          return false;
+        value = std::stoi(data.substr(i, last - i));
+        return true;
+      };
+      int gen, num;
+      if (skip_space() && read_number(gen) && skip_space() && read_number(num))
+        ids.push_back(num);
+    }
+  }
+
+  void GetChangedObjects(PdfDoc* doc, const std::wstring& path, uint64_t from_offset,
+    std::set<int>& changed) {
+    std::ifstream ifs(ToUtf8(path), std::ios::binary | std::ios::ate);
+    if (!ifs)
+      throw std::runtime_error("Failed to open " + ToUtf8(path));
+    uint64_t size = (uint64_t)ifs.tellg();
+    if (size <= from_offset)
+      return;
+    std::string data((size_t)(size - from_offset), '\0');
+    ifs.seekg(from_offset);
+    ifs.read(&data[0], data.size());
+
+    std::vector<int> ids;
+    FindObjectHeaders(data, ids);
+    for (auto id : ids) {
+      changed.insert(id);
+      // objects compressed in an object stream are listed in its header
+      auto object = doc->GetObjectById(id);
+      if (!object || object->GetObjectType() != kPdsStream)
+        continue;
+      auto stream = (PdsStream*)object;
+      auto dict = stream->GetStreamDict();
+      if (dict->GetText(L"Type") != L"ObjStm")
+        continue;
+      auto count = dict->GetInteger(L"N", 0);
+      auto first = dict->GetInteger(L"First", 0);
+      std::string header(first, '\0');
+      if (first <= 0 || !stream->Read(0, (uint8_t*)&header[0], first))
+        continue;
+      std::istringstream iss(header);
+      int num, offset;
+      for (int i = 0; i < count && (iss >> num >> offset); i++)
+        changed.insert(num);
+    }
+  }
+
+  static void CollectDependencies(PdsObject* object, std::unordered_set<int>& visited,
+    std::vector<int>& deps) {
+    if (!object)
+      return;
+    auto id = object->GetId();
+    if (id != 0) {
+      if (!visited.insert(id).second)
+        return;
+      deps.push_back(id);
+    }
+    switch (object->GetObjectType()) {
+    case kPdsArray: {
+      auto array = (PdsArray*)object;
+      for (int i = 0; i < array->GetNumObjects(); i++)
+        CollectDependencies(array->Get(i), visited, deps);
+      break;
+    }
+    case kPdsStream:
+    case kPdsDictionary: {
+      auto dict = object->GetObjectType() == kPdsStream ?
+        ((PdsStream*)object)->GetStreamDict() : (PdsDictionary*)object;
+      for (int i = 0; i < dict->GetNumKeys(); i++) {
+        // back links lead to the page tree and other pages
+        auto key = dict->GetKey(i);
+        if (key != L"Parent" && key != L"P")
+          CollectDependencies(dict->Get(key.c_str()), visited, deps);
+      }
+      break;
+    }
+    default:;
+    }
+  }
+
+  void GetPageDependencies(PdfPage* page, std::vector<int>& deps) {
+    auto page_dict = page->GetObject();
+    if (!page_dict)
+      throw PdfixException();
+    std::unordered_set<int> visited;
+    CollectDependencies(page_dict, visited, deps);
+    // ancestor page tree nodes, a rewritten node may change inherited attributes given directly
+    // in it, objects of the inherited attributes are followed too
+    std::unordered_set<int> ancestors;
+    auto node = page_dict->GetDictionary(L"Parent");
+    for (; node; node = node->GetDictionary(L"Parent")) {
+      auto id = node->GetId();
+      if (id != 0) {
+        if (!ancestors.insert(id).second)
+          break;
+        if (visited.insert(id).second)
+          deps.push_back(id);
+      }
+      for (auto key : { L"Resources", L"MediaBox", L"CropBox", L"Rotate" }) {
+        if (node->Known(key))
+          CollectDependencies(node->Get(key), visited, deps);
+      }
+    }
+    std::sort(deps.begin(), deps.end());
+  }
+
+  int ExtractPages(
+    PdfDoc* doc,                                          // document to extract
+    const std::wstring& open_path,                        // path of the document
+    Cache& cache,                                         // previous extraction
+    uint64_t options,                                     // hash of the options of extract_page
+    const std::function<void(PdfPage*, ptree&)>& extract_page,  // page extraction
+    size_t thread_count                                   // max number of threads
+  ) {
+    std::ifstream ifs(ToUtf8(open_path), std::ios::binary | std::ios::ate);
+    if (!ifs)
+      throw std::runtime_error("Failed to open " + ToUtf8(open_path));
+    uint64_t file_size = (uint64_t)ifs.tellg();
+    ifs.close();
+
+    // the cache is usable only if the document was appended to since the previous run and the
+    // pages were extracted with the same options
+    bool incremental = cache.options == options && cache.file_size > 0 &&
+      cache.file_size <= file_size && GetTailHash(open_path, cache.file_size) == cache.tail_hash;
+    std::set<int> changed;
+    if (incremental)
+      GetChangedObjects(doc, open_path, cache.file_size, changed);
+
+    auto num_pages = doc->GetNumPages();
+    std::vector<PageEntry> pages(num_pages);
+    std::vector<int> extracted(num_pages, 0);
+    auto extract_pages = [&](int from, int to) {
+      for (int i = from; i <= to; i++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        auto page_id = page->GetObject()->GetId();
+
+        // pages keep their index and none of their objects was rewritten
+        if (incremental && i < (int)cache.pages.size() && cache.pages[i].page_id == page_id) {
+          auto& cached = cache.pages[i];
+          bool modified = std::any_of(cached.deps.begin(), cached.deps.end(),
+            [&](int id) { return changed.count(id) > 0; });
+          if (!modified) {
+            pages[i] = std::move(cached);
+            continue;
+          }
+        }
+
+        pages[i].page_id = page_id;
+        GetPageDependencies(page.get(), pages[i].deps);
+        extract_page(page.get(), pages[i].data);
+        extracted[i] = 1;
+      }
+    };
+    ParallelFor(0, num_pages - 1, thread_count, extract_pages);
+
+    cache.file_size = file_size;
+    cache.tail_hash = GetTailHash(open_path, file_size);
+    cache.options = options;
+    cache.pages = std::move(pages);
+    return (int)std::count(extracted.begin(), extracted.end(), 1);
+  }
+} // namespace IncrementalExtraction
@@ -8,6 +8,11 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include <memory>
+#include "pdfixsdksamples/ImageCache.h"
+#include "pdfixsdksamples/EditContent.h"
+#include "pdfixsdksamples/PageFingerprint.h"
+#include "pdfixsdksamples/Utils.h"
 #include "Pdfix.h"
 #include "OcrTesseract.h"
 
@@ -34,13 +39,110 @@ void parse_page_element(PdeElement* elem, std::vector<PdfRect>& image_bbox_arr)
   }
 }
 
+// collects images of the page, repeated images are marked to reuse the text of the first occurrence
+void parse_page_images(PdeElement* elem, std::vector<PageImage>& images, ImageCache* image_cache,
+  int& duplicates) {
+  if (!elem)
+    return;
+  if (elem->GetType() == kPdeImage) {
+    PageImage image;
+    image.bbox = elem->GetBBox();
+    image.fingerprint = image_cache->GetFingerprint(elem);
+    std::string first_ref;
+    image.repeated = image_cache->Lookup(image.fingerprint, "", first_ref);
+    if (image.repeated)
+      duplicates++;
+    images.push_back(image);
+  }
+  else {
+    for (int i = 0; i < elem->GetNumChildren(); i++)
+      parse_page_images(elem->GetChild(i), images, image_cache, duplicates);
+  }
+}
+
+void CaptureOcrText(PdsContent* content, int first_object, const PdfRect& bbox,
+  std::vector<ImageText>& text) {
+  auto width = bbox.right - bbox.left;
+  auto height = bbox.top - bbox.bottom;
+  if (width <= 0 || height <= 0)
+    return;
+  for (int i = first_object; i < content->GetNumObjects(); i++) {
+    auto object = content->GetObject(i);
+    if (!object)
+      continue;
+    if (object->GetObjectType() == kPdsPageForm) {
+      CaptureOcrText(((PdsForm*)object)->GetContent(), 0, bbox, text);
+      continue;
+    }
+    if (object->GetObjectType() != kPdsPageText)
+      continue;
+    ImageText item;
+    item.text = ((PdsText*)object)->GetText();
+    if (item.text.empty())
+      continue;
+    auto rect = object->GetBBox();
+    item.rect.left = (rect.left - bbox.left) / width;
+    item.rect.right = (rect.right - bbox.left) / width;
+    item.rect.bottom = (rect.bottom - bbox.bottom) / height;
+    item.rect.top = (rect.top - bbox.bottom) / height;
+    text.push_back(item);
+  }
+}
+
+void ReplayOcrText(EditContent::ResourceCache& cache, PdsContent* content,
+  const std::vector<ImageText>& text, const PdfRect& bbox) {
+  auto width = bbox.right - bbox.left;
+  auto height = bbox.top - bbox.bottom;
+  auto font = cache.GetFont(L"Arial", 0);
+  for (auto& item : text) {
+    PdfRect rect;
+    rect.left = bbox.left + item.rect.left * width;
+    rect.right = bbox.left + item.rect.right * width;
+    rect.bottom = bbox.bottom + item.rect.bottom * height;
+    rect.top = bbox.bottom + item.rect.top * height;
+
+    PdfMatrix matrix;
+    matrix.a = 1;
+    matrix.b = 0;
+    matrix.c = 0;
+    matrix.d = 1;
+    matrix.e = rect.left;
+    matrix.f = rect.bottom;
+    auto text_obj = content->AddNewText(-1, font, &matrix);
+    if (!text_obj)
+      throw PdfixException();
+    if (!text_obj->SetText(item.text.c_str()))
+      throw PdfixException();
+
+    // the text is not painted, it only makes the image searchable
+    PdfTextState ts;
+    ts.font = font;
+    ts.font_size = rect.top - rect.bottom;
+    ts.color_state.fill_type = kFillTypeNone;
+    ts.color_state.stroke_type = kFillTypeNone;
+    if (!text_obj->SetTextState(&ts))
+      throw PdfixException();
+
+    // character spacing stretches the text over the recognized width
+    auto text_bbox = text_obj->GetBBox();
+    auto length = item.text.length();
+    if (length > 1) {
+      ts.char_spacing = ((rect.right - rect.left) - (text_bbox.right - text_bbox.left)) / length;
+      if (!text_obj->SetTextState(&ts))
+        throw PdfixException();
+    }
+  }
+}
+
 void OcrPageImagesWithTesseract(
   const std::wstring& open_path,                  // source PDF document
   const std::wstring& save_path,                  // searchable PDF document
   const std::wstring& data_path,                  // path to OCR data
   const std::wstring& language,                   // default OCR language
   const double zoom,                              // zoom to control page rendering quality
-  const PdfRotate rotate                          // page rotation to be applied
+  const PdfRotate rotate,                         // page rotation to be applied
+  ImageCache* image_cache,                        // cache of already OCRed images, may be null
+  FingerprintStore* fingerprint_store             // pages with known fingerprint reuse the stored text
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -65,25 +167,6 @@ void OcrPageImagesWithTesseract(
   if (!doc)
     throw PdfixException();
   
-  // collect page images
-  std::vector<PdfRect> image_bbox_arr;
-  
-  PdfPage* page = doc->AcquirePage(0);
-  if (!page)
-    throw PdfixException();
-
-  // find images on the page and collect bounding boxes to ocr
-  PdePageMap* page_map = page->AcquirePageMap();
-  if (!page_map)
-    throw PdfixException();
-  if (!page_map->CreateElements(nullptr, nullptr))
-    throw PdfixException();
-    
-  PdeElement* elem = page_map->GetElement();
-  parse_page_element(elem, image_bbox_arr);
-  
-  page_map->Release();
-
   // setup the ocr engine
   ocr->SetLanguage(language.c_str());
   ocr->SetDataPath(data_path.c_str());
@@ -91,47 +174,133 @@ void OcrPageImagesWithTesseract(
   TesseractDoc* ocr_doc = ocr->OpenOcrDoc(doc);
   if (!ocr_doc)
     throw PdfixException();
-  
-  // prepare page rendering matrix
-  PdfPageView* page_view = page->AcquirePageView(zoom, rotate);
-  
-  // run ocr on each image bbox
-  for (auto& bbox : image_bbox_arr) {
-    // render page to image
-    PdfDevRect dev_rect;
-    page_view->RectToDevice(&bbox, &dev_rect);
-    int width = dev_rect.right - dev_rect.left;
-    int height = dev_rect.bottom - dev_rect.top;
-    
-    PsImage* image = pdfix->CreateImage(width, height, kImageDIBFormatArgb);
-
-    // render portion of the page - the image
-    PdfPageRenderParams render_params;
-    page_view->GetDeviceMatrix(&render_params.matrix);
-    render_params.image = image;
-    render_params.clip_box = bbox;
-    if (!page->DrawContent(&render_params, nullptr, nullptr))
+
+  // repeated images (logos, signatures) are OCRed only at their first occurrence, the recognized
+  // text is replayed at the other ones
+  ImageCache local_cache;
+  if (!image_cache)
+    image_cache = &local_cache;
+  EditContent::ResourceCache resources(pdfix, doc);
+  int duplicates = 0;
+
+  PageHasher hasher;
+  for (int i = 0; i < doc->GetNumPages(); i++) {
+    // collect page images
+    std::vector<PageImage> images;
+
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+    if (!page)
       throw PdfixException();
-    
-    // calculate PdfMatrix to position the recognized text on the page
-    auto rotate = ((page->GetRotate() / 90) % 4);
-    PdfMatrix matrix;
-    PdfMatrixRotate(matrix, rotate * kPi / 2, false);
-    PdfMatrixScale(matrix, 1/zoom, 1/zoom, false);
-    switch (rotate) {
-      case 0: PdfMatrixTranslate(matrix, bbox.left, bbox.bottom, false); break;
-      case 1: PdfMatrixTranslate(matrix, bbox.right, bbox.bottom, false); break;
-      case 2: PdfMatrixTranslate(matrix, bbox.right, bbox.top, false); break;
-      case 3: PdfMatrixTranslate(matrix, bbox.left, bbox.top, false); break;
+
+    PdfRect crop_box;
+    page->GetCropBox(&crop_box);
+
+    // fingerprint of the page before the recognized text is added, the text also depends on the
+    // language and the rendering
+    uint64_t fingerprint = 0;
+    if (fingerprint_store) {
+      fingerprint = hasher.GetFingerprint(page.get());
+      fingerprint = HashBytes(language.data(), language.length() * sizeof(wchar_t), fingerprint);
+      fingerprint = HashBytes(&zoom, sizeof(zoom), fingerprint);
+      fingerprint = HashBytes(&rotate, sizeof(rotate), fingerprint);
+      std::string result;
+      std::vector<ImageText> text;
+      if (fingerprint_store->Find(fingerprint, result) && ReadImageText(result, text)) {
+        // text of all images recognized on the same page before is added without running the ocr
+        ReplayOcrText(resources, page->GetContent(), text, crop_box);
+        if (!text.empty() && !page->SetContent())
+          throw PdfixException();
+        continue;
+      }
     }
-    
-    if (!ocr_doc->OcrImageToPage(image, &matrix, page, nullptr, nullptr))
+
+    // find images on the page and collect bounding boxes to ocr
+    PdePageMap* page_map = page->AcquirePageMap();
+    if (!page_map)
+      throw PdfixException();
+    if (!page_map->CreateElements(nullptr, nullptr))
       throw PdfixException();
-    
-    image->Destroy();
+
+    PdeElement* elem = page_map->GetElement();
+    parse_page_images(elem, images, image_cache, duplicates);
+
+    page_map->Release();
+
+    if (images.empty()) {
+      if (fingerprint_store)
+        fingerprint_store->Add(fingerprint, "");
+      continue;
+    }
+
+    // prepare page rendering matrix
+    auto page_view_deleter = [](PdfPageView* page_view) { page_view->Release(); };
+    std::unique_ptr<PdfPageView, decltype(page_view_deleter)>
+      page_view(page->AcquirePageView(zoom, rotate), page_view_deleter);
+    if (!page_view)
+      throw PdfixException();
+
+    // run ocr on each image bbox, text added to the page is stored with the page fingerprint
+    auto page_first_object = page->GetContent()->GetNumObjects();
+    bool replayed = false;
+    for (auto& page_image : images) {
+      auto& bbox = page_image.bbox;
+      std::vector<ImageText> text;
+      if (page_image.repeated && image_cache->GetText(page_image.fingerprint, text)) {
+        ReplayOcrText(resources, page->GetContent(), text, bbox);
+        replayed = true;
+        continue;
+      }
+
+      // render page to image
+      PdfDevRect dev_rect;
+      page_view->RectToDevice(&bbox, &dev_rect);
+      int width = dev_rect.right - dev_rect.left;
+      int height = dev_rect.bottom - dev_rect.top;
+
+      PsImage* image = pdfix->CreateImage(width, height, kImageDIBFormatArgb);
+
+      // render portion of the page - the image
+      PdfPageRenderParams render_params;
+      page_view->GetDeviceMatrix(&render_params.matrix);
+      render_params.image = image;
+      render_params.clip_box = bbox;
+      if (!page->DrawContent(&render_params, nullptr, nullptr))
+        throw PdfixException();
+
+      // calculate PdfMatrix to position the recognized text on the page
+      auto rotate = ((page->GetRotate() / 90) % 4);
+      PdfMatrix matrix;
+      PdfMatrixRotate(matrix, rotate * kPi / 2, false);
+      PdfMatrixScale(matrix, 1/zoom, 1/zoom, false);
+      switch (rotate) {
+        case 0: PdfMatrixTranslate(matrix, bbox.left, bbox.bottom, false); break;
+        case 1: PdfMatrixTranslate(matrix, bbox.right, bbox.bottom, false); break;
+        case 2: PdfMatrixTranslate(matrix, bbox.right, bbox.top, false); break;
+        case 3: PdfMatrixTranslate(matrix, bbox.left, bbox.top, false); break;
+      }
+
+      // text objects added by the ocr are kept for later occurrences of the image
+      auto first_object = page->GetContent()->GetNumObjects();
+      if (!ocr_doc->OcrImageToPage(image, &matrix, page.get(), nullptr, nullptr))
+        throw PdfixException();
+      CaptureOcrText(page->GetContent(), first_object, bbox, text);
+      image_cache->SetText(page_image.fingerprint, std::move(text));
+
+      image->Destroy();
+    }
+    if (replayed && !page->SetContent())
+      throw PdfixException();
+    if (fingerprint_store) {
+      std::vector<ImageText> text;
+      CaptureOcrText(page->GetContent(), page_first_object, crop_box, text);
+      fingerprint_store->Add(fingerprint, WriteImageText(text));
+    }
   }
-  
-  page->Release();
+  std::cout << "replayed repeated images: " << duplicates << std::endl;
+  image_cache->Report(std::cout);
+  if (fingerprint_store)
+    fingerprint_store->Report(std::cout);
 
   if (!doc->Save(save_path.c_str(), kSaveFull))
     throw PdfixException();
@@ -139,6 +308,7 @@ void OcrPageImagesWithTesseract(
   ocr_doc->Close();
   ocr->Destroy();
 
+  image_cache->ReleaseDocument(doc);
   doc->Close();
   pdfix->Destroy();
 }
\ No newline at end of file
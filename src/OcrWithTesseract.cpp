@@ -8,6 +8,8 @@
 #include <string>
 #include <iostream>
 #include "pdfixsdksamples/Utils.h"
+#include "pdfixsdksamples/EditContent.h"
+#include "pdfixsdksamples/OcrPageImagesWithTesseract.h"
 #include "Pdfix.h"
 #include "OcrTesseract.h"
 
@@ -19,7 +21,8 @@ void OcrWithTesseract(
   const std::wstring& data_path,                  // path to OCR data
   const std::wstring& language,                   // default OCR language
   const double zoom,                              // page zoom level for rendering to control image processing quality
-  const PdfRotate rotate                          // page rotation
+  const PdfRotate rotate,                         // page rotation
+  FingerprintStore* fingerprint_store             // pages with known fingerprint reuse the stored text
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -56,12 +59,36 @@ void OcrWithTesseract(
     throw PdfixException();
   
   // ocr each page in the document
+  EditContent::ResourceCache resources(pdfix, doc);
+  PageHasher hasher;
   for (int i = 0; i < doc->GetNumPages(); i++) {
     PdfPage* page = doc->AcquirePage(i);
-    
+    if (!page)
+      throw PdfixException();
+
     PdfRect crop_box;
     page->GetCropBox(&crop_box);
-    
+
+    // fingerprint of the page before the recognized text is added, the text also depends on the
+    // language and the rendering
+    uint64_t fingerprint = 0;
+    if (fingerprint_store) {
+      fingerprint = hasher.GetFingerprint(page);
+      fingerprint = HashBytes(language.data(), language.length() * sizeof(wchar_t), fingerprint);
+      fingerprint = HashBytes(&zoom, sizeof(zoom), fingerprint);
+      fingerprint = HashBytes(&rotate, sizeof(rotate), fingerprint);
+      std::string result;
+      std::vector<ImageText> text;
+      if (fingerprint_store->Find(fingerprint, result) && ReadImageText(result, text)) {
+        // text recognized on the same page before is added without running the ocr
+        ReplayOcrText(resources, page->GetContent(), text, crop_box);
+        if (!text.empty() && !page->SetContent())
+          throw PdfixException();
+        page->Release();
+        continue;
+      }
+    }
+
     PdfPageView* page_view = page->AcquirePageView(zoom, rotate);
     
     // draw page to an image
@@ -89,11 +116,20 @@ void OcrWithTesseract(
       case 3: PdfMatrixTranslate(matrix, crop_box.left, crop_box.top, false); break;
     }
 
+    // text objects added by the ocr are stored for pages with the same fingerprint
+    auto first_object = page->GetContent()->GetNumObjects();
     if (!ocr_doc->OcrImageToPage(image, &matrix, page, nullptr, nullptr))
       throw PdfixException();
-    
+
+    if (fingerprint_store) {
+      std::vector<ImageText> text;
+      CaptureOcrText(page->GetContent(), first_object, crop_box, text);
+      fingerprint_store->Add(fingerprint, WriteImageText(text));
+    }
     page->Release();
   }
+  if (fingerprint_store)
+    fingerprint_store->Report(std::cout);
   
   if (!doc->Save(save_path.c_str(), kSaveFull))
     throw PdfixException();
@@ -0,0 +1,225 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// PageFingerprint.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/PageFingerprint.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+static uint64_t HashText(const std::wstring& text, uint64_t hash) {
+  return HashBytes(text.data(), text.length() * sizeof(wchar_t), hash);
+}
+
+uint64_t PageHasher::HashObject(PdsObject* object, uint64_t hash) {
+  if (!object)
+    return HashBytes("null", 4, hash);
+
+  // indirect objects are hashed once, object numbers are not part of the hash
+  auto id = object->GetId();
+  if (id != 0) {
+    auto found = m_hashes.find(id);
+    if (found != m_hashes.end())
+      return HashBytes(&found->second, sizeof(found->second), hash);
+    if (!m_visiting.insert(id).second)
+      return HashBytes("cycle", 5, hash);
+  }
+
+  uint64_t object_hash = kHashSeed;
+  auto type = (int)object->GetObjectType();
+  object_hash = HashBytes(&type, sizeof(type), object_hash);
+  switch (object->GetObjectType()) {
+  case kPdsBoolean: {
+    bool value = ((PdsBoolean*)object)->GetValue();
+    object_hash = HashBytes(&value, sizeof(value), object_hash);
+    break;
+  }
+  case kPdsNumber: {
+    double value = ((PdsNumber*)object)->GetValue();
+    object_hash = HashBytes(&value, sizeof(value), object_hash);
+    break;
+  }
+  case kPdsString:
+    object_hash = HashText(((PdsString*)object)->GetText(), object_hash);
+    break;
+  case kPdsName:
+    object_hash = HashText(((PdsName*)object)->GetText(), object_hash);
+    break;
+  case kPdsArray: {
+    auto array = (PdsArray*)object;
+    for (int i = 0; i < array->GetNumObjects(); i++)
+      object_hash = HashObject(array->Get(i), object_hash);
+    break;
+  }
+  case kPdsStream:
+  case kPdsDictionary: {
+    auto dict = object->GetObjectType() == kPdsStream ?
+      ((PdsStream*)object)->GetStreamDict() : (PdsDictionary*)object;
+    // keys in canonical order, back links and structure ids do not change the appearance
+    std::vector<std::wstring> keys;
+    for (int i = 0; i < dict->GetNumKeys(); i++) {
+      auto key = dict->GetKey(i);
+      if (key != L"Parent" && key != L"P" && key != L"StructParent" && key != L"StructParents" &&
+        key != L"Length" && key != L"Filter" && key != L"DecodeParms")
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    for (auto& key : keys) {
+      object_hash = HashText(key, object_hash);
+      object_hash = HashObject(dict->Get(key.c_str()), object_hash);
+    }
+    // decoded data, so that differently compressed streams match
+    if (object->GetObjectType() == kPdsStream) {
+      auto stream = (PdsStream*)object;
+      auto size = stream->GetSize();
+      std::vector<uint8_t> data(std::max(size, 0));
+      if (size > 0 && stream->Read(0, data.data(), size))
+        object_hash = HashBytes(data.data(), data.size(), object_hash);
+    }
+    break;
+  }
+  default:;
+  }
+
+  if (id != 0) {
+    m_visiting.erase(id);
+    m_hashes[id] = object_hash;
+  }
+  return HashBytes(&object_hash, sizeof(object_hash), hash);
+}
+
+uint64_t PageHasher::GetFingerprint(PdfPage* page) {
+  auto page_dict = page->GetObject();
+  if (!page_dict)
+    throw PdfixException();
+
+  uint64_t hash = kHashSeed;
+  for (auto key : { L"Contents", L"Annots", L"MediaBox", L"CropBox" })
+    hash = HashObject(page_dict->Get(key), hash);
+
+  // resources and rotation may be inherited from the page tree
+  auto rotate = page->GetRotate();
+  hash = HashBytes(&rotate, sizeof(rotate), hash);
+  PdsDictionary* node = page_dict;
+  while (node && !node->Known(L"Resources"))
+    node = node->GetDictionary(L"Parent");
+  hash = HashObject(node ? node->Get(L"Resources") : nullptr, hash);
+  // 0 is reserved for missing fingerprints
+  return hash ? hash : 1;
+}
+
+uint64_t GetPageFingerprint(PdfPage* page) {
+  PageHasher hasher;
+  return hasher.GetFingerprint(page);
+}
+
+// results are saved one per line after the fingerprint, line breaks and tabs are escaped
+static std::string EscapeResult(const std::string& result) {
+  std::string escaped;
+  escaped.reserve(result.size());
+  for (auto ch : result) {
+    switch (ch) {
+    case '\\': escaped += "\\\\"; break;
+    case '\n': escaped += "\\n"; break;
+    case '\r': escaped += "\\r"; break;
+    case '\t': escaped += "\\t"; break;
+    default: escaped += ch;
+    }
+  }
+  return escaped;
+}
+
+static std::string UnescapeResult(const std::string& escaped) {
+  std::string result;
+  result.reserve(escaped.size());
+  for (size_t i = 0; i < escaped.size(); i++) {
+    if (escaped[i] != '\\' || i + 1 == escaped.size()) {
+      result += escaped[i];
+      continue;
+    }
+    switch (escaped[++i]) {
+    case 'n': result += '\n'; break;
+    case 'r': result += '\r'; break;
+    case 't': result += '\t'; break;
+    default: result += escaped[i];
+    }
+  }
+  return result;
+}
+
+bool FingerprintStore::Load(const std::wstring& path) {
+  std::ifstream ifs(ToUtf8(path), std::ios::binary);
+  if (!ifs)
+    return false;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::string line;
+  while (std::getline(ifs, line)) {
+    // lines without a result can't be replayed, the page is processed again
+    auto tab = line.find('\t');
+    if (tab == std::string::npos || tab == 0)
+      continue;
+    try {
+      m_results[std::stoull(line.substr(0, tab), nullptr, 16)] = UnescapeResult(line.substr(tab + 1));
+    }
+    catch (std::logic_error&) {
+    }
+  }
+  return true;
+}
+
+bool FingerprintStore::Save(const std::wstring& path) {
+  std::ofstream ofs(ToUtf8(path), std::ios::binary);
+  if (!ofs)
+    return false;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ofs << std::hex;
+  for (auto& result : m_results)
+    ofs << result.first << '\t' << EscapeResult(result.second) << '\n';
+  return (bool)ofs;
+}
+
+bool FingerprintStore::Find(uint64_t fingerprint, std::string& result) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_checked++;
+  auto found = m_results.find(fingerprint);
+  if (found == m_results.end())
+    return false;
+  result = found->second;
+  m_skipped++;
+  return true;
+}
+
+void FingerprintStore::Add(uint64_t fingerprint, const std::string& result) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_results[fingerprint] = result;
+}
+
+size_t FingerprintStore::GetNumChecked() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_checked;
+}
+
+size_t FingerprintStore::GetNumSkipped() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_skipped;
+}
+
+double FingerprintStore::GetSkipRate() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_checked ? (double)m_skipped / m_checked : 0.;
+}
+
+void FingerprintStore::Report(std::ostream& output) {
+  auto checked = GetNumChecked();
+  auto skipped = GetNumSkipped();
+  output << "pages: " << checked << ", skipped: " << skipped << " (" << 100. * GetSkipRate()
+    << "%)" << std::endl;
+}
@@ -13,6 +13,8 @@
 // project
 #include "Pdfix.h"
 #include "pdfixsdksamples/ExtractText.h"
+#include "pdfixsdksamples/IncrementalExtraction.h"
+#include "pdfixsdksamples/Utils.h"
 
 using namespace PDFixSDK;
 using namespace boost::property_tree;
@@ -79,4 +81,45 @@ namespace PagesToJson {
     doc->Close();
     pdfix->Destroy();
   }
-}
\ No newline at end of file
+
+  void RunIncremental(
+    const std::wstring& open_path,                      // source PDF document
+    const std::wstring& password,                       // open document password
+    const std::wstring& cache_path,                     // cache of the previous run
+    std::ostream& output,                               // output stream
+    int export_flags,                                   // export flags
+    size_t thread_count                                 // max number of threads
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    std::unique_ptr<PdfDoc, decltype(doc_deleter)>
+      doc(pdfix->OpenDoc(open_path.c_str(), password.c_str()), doc_deleter);
+    if (!doc)
+      throw PdfixException();
+
+    IncrementalExtraction::Cache cache;
+    cache.Load(cache_path);
+    auto options = HashBytes(&export_flags, sizeof(export_flags));
+    IncrementalExtraction::ExtractPages(doc.get(), open_path, cache, options,
+      [&](PdfPage* page, ptree& json) { ProcessPage(page, json, export_flags); }, thread_count);
+
+    ptree pages_root;
+    for (auto& entry : cache.pages)
+      pages_root.push_back(std::make_pair("", entry.data));
+    ptree output_json;
+    output_json.add_child("pages", pages_root);
+    write_json(output, output_json, false);
+
+    doc.reset();
+    if (!cache.Save(cache_path))
+      throw std::runtime_error("Failed to save " + ToUtf8(cache_path));
+
+    pdfix->Destroy();
+  }
+}
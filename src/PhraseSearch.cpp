@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// PhraseSearch.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/PhraseSearch.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <cmath>
+#include <cwctype>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace PhraseSearch {
+
+  static const wchar_t kSoftHyphen = 0x00AD;
+
+  static bool IsSpace(wchar_t ch) {
+    return std::iswspace(ch) || ch == 0x00A0;
+  }
+
+  static bool IsHyphen(wchar_t ch) {
+    return ch == L'-' || ch == kSoftHyphen || ch == 0x2010;
+  }
+
+  std::wstring NormalizeText(const std::wstring& text, bool fold_case) {
+    std::wstring result;
+    result.reserve(text.length());
+    for (auto ch : text) {
+      if (ch == kSoftHyphen)
+        continue;
+      if (IsSpace(ch)) {
+        if (!result.empty() && result.back() != L' ')
+          result += L' ';
+        continue;
+      }
+      result += fold_case ? (wchar_t)std::towlower(ch) : ch;
+    }
+    if (!result.empty() && result.back() == L' ')
+      result.pop_back();
+    return result;
+  }
+
+  // returns true if the word next continues on a new line after the word prev
+  static bool IsLineBreak(const PdfQuad& prev, const PdfQuad& next) {
+    auto prev_height = std::abs(prev.tl.y - prev.bl.y);
+    auto prev_center = (prev.tl.y + prev.bl.y) / 2;
+    auto next_center = (next.tl.y + next.bl.y) / 2;
+    if (std::abs(prev_center - next_center) > prev_height / 2)
+      return true;
+    // next word starts left of the previous one on the same baseline (columns)
+    return next.bl.x < prev.bl.x;
+  }
+
+  void BuildTextStream(PdfPage* page, TextStream& stream) {
+    auto word_list_deleter = [](PdsWordList* word_list) { word_list->Release(); };
+    std::unique_ptr<PdsWordList, decltype(word_list_deleter)>
+      word_list(page->AcquireWordList(kWordFinderAlgLatest), word_list_deleter);
+    if (!word_list)
+      throw PdfixException();
+
+    int word_count = word_list->GetNumWords();
+    stream.word_starts.reserve(word_count);
+    stream.word_quads.reserve(word_count);
+
+    bool hyphenated = false;    // previous word ends with a hyphen
+    bool hyphen_in_text = false; // the hyphen is kept in the text (soft hyphens are removed)
+    for (int i = 0; i < word_count; i++) {
+      auto word = word_list->GetWord(i);
+      if (!word)
+        throw PdfixException();
+      auto quad = word->GetQuad();
+      auto text = NormalizeText(word->GetText(), false);
+
+      bool line_break = i == 0 || IsLineBreak(stream.word_quads.back(), quad);
+      if (line_break)
+        stream.line_starts.push_back(i);
+
+      if (i > 0) {
+        if (line_break && hyphenated && !text.empty() && std::iswalpha(text.front())) {
+          // join the word hyphenated across the line break, drop the hyphen
+          if (hyphen_in_text)
+            stream.text.pop_back();
+        }
+        else if (!stream.text.empty())
+          stream.text += L' ';
+      }
+      stream.word_starts.push_back((int)stream.text.length());
+      stream.word_quads.push_back(quad);
+
+      // soft hyphens were already removed from the text, check the original text
+      auto raw_text = word->GetText();
+      hyphen_in_text = !raw_text.empty() && raw_text.back() != kSoftHyphen;
+      hyphenated = !raw_text.empty() && IsHyphen(raw_text.back()) &&
+        text.length() > (hyphen_in_text ? 1u : 0u);
+      stream.text += text;
+    }
+
+    stream.folded.resize(stream.text.length());
+    std::transform(stream.text.begin(), stream.text.end(), stream.folded.begin(),
+      [](wchar_t ch) { return (wchar_t)std::towlower(ch); });
+  }
+
+  void GetRangeQuads(const TextStream& stream, int offset, int length, std::vector<PdfQuad>& quads) {
+    auto& starts = stream.word_starts;
+    if (length <= 0 || starts.empty())
+      return;
+    auto first = std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+    auto last = std::upper_bound(starts.begin(), starts.end(), offset + length - 1) - starts.begin();
+    for (auto i = std::max<ptrdiff_t>(first, 0); i < last; i++)
+      quads.push_back(stream.word_quads[i]);
+  }
+
+  void FindPhrase(const TextStream& stream, const std::wstring& phrase, int page_num,
+    std::vector<Hit>& hits) {
+    auto query = NormalizeText(phrase, true);
+    if (query.empty())
+      return;
+
+    // single linear scan over the page text
+    auto& text = stream.folded;
+    std::boyer_moore_horspool_searcher<std::wstring::const_iterator> searcher(query.begin(), query.end());
+    auto it = text.begin();
+    while (true) {
+      it = std::search(it, text.end(), searcher);
+      if (it == text.end())
+        break;
+      Hit hit;
+      hit.page_num = page_num;
+      hit.offset = (int)(it - text.begin());
+      hit.length = (int)query.length();
+      hit.text = stream.text.substr(hit.offset, hit.length);
+      GetRangeQuads(stream, hit.offset, hit.length, hit.quads);
+      hits.push_back(hit);
+      it += query.length();
+    }
+  }
+
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& phrase,           // phrase to search
+    std::ostream& output,                 // output stream
+    int page_num,                         // page to search, -1 for all pages
+    size_t thread_count                   // max number of threads
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    auto from_page = page_num == -1 ? 0 : page_num;
+    auto to_page = page_num == -1 ? doc->GetNumPages() - 1 : page_num;
+
+    std::vector<std::vector<Hit>> page_hits(to_page - from_page + 1);
+    auto search_pages = [&](int from, int to) {
+      for (int i = from; i <= to; i++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        TextStream stream;
+        BuildTextStream(page.get(), stream);
+        FindPhrase(stream, phrase, i, page_hits[i - from_page]);
+      }
+    };
+    ParallelFor(from_page, to_page, thread_count, search_pages);
+
+    for (auto& hits : page_hits) {
+      for (auto& hit : hits) {
+        output << "page " << hit.page_num + 1 << ": " << ToUtf8(hit.text) << std::endl;
+        for (auto& quad : hit.quads) {
+          output << "  [" << quad.bl.x << ", " << quad.bl.y << ", " << quad.tr.x << ", "
+            << quad.tr.y << "]" << std::endl;
+        }
+      }
+    }
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+} // namespace PhraseSearch
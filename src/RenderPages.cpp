@@ -8,7 +8,11 @@
 #include <string>
 #include <iostream>
 #include <thread>
+#include <vector>
 #include <sstream>
+#include <fstream>
+#include <cstdio>
+#include "pdfixsdksamples/Utils.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
@@ -22,7 +26,8 @@ void RenderPages(
   double zoom,                                // page zoom
   PdfRotate rotate,                           // page rotation
   PdfDevRect clip_rect,                       // clip region
-  size_t thread_count                         // max number of threads
+  size_t thread_count,                        // max number of threads
+  FingerprintStore* fingerprint_store         // pages with known fingerprint copy the stored image
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -42,12 +47,67 @@ void RenderPages(
   if (page_from > page_count || page_to > page_count)
     throw std::runtime_error("Page number out of range");
 
+  auto read_file = [](const std::string& path, std::string& data) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+      return false;
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    data = oss.str();
+    return true;
+  };
+  auto hash_data = [](const std::string& data) {
+    char hash_str[17];
+    snprintf(hash_str, sizeof(hash_str), "%016llx",
+      (unsigned long long)HashBytes(data.data(), data.size()));
+    return std::string(hash_str);
+  };
+
+  // The store keeps the hash of the image with its path, "<hash> <path>". The file may have been
+  // overwritten since, it's copied only if it still has the rendered content.
+  auto copy_image = [&](const std::string& result, const std::wstring& to_path) {
+    auto space = result.find(' ');
+    if (space == std::string::npos)
+      return false;
+    std::string data;
+    auto from_path = result.substr(space + 1);
+    if (!read_file(from_path, data))
+      return false;
+    if (result.substr(0, space) != hash_data(data))
+      return false;
+    if (from_path == ToUtf8(to_path))
+      return true;
+    std::ofstream ofs(ToUtf8(to_path), std::ios::binary | std::ios::trunc);
+    ofs.write(data.data(), data.size());
+    return (bool)ofs;
+  };
+
   auto render_page = [&](auto from, auto to) {
+    PageHasher hasher;
     for (size_t i = from; i <= to; i++) {
       // render first page to jpg image
       PdfPage* page = doc->AcquirePage(i);
       if (!page)
         throw PdfixException();
+
+      std::wstringstream ss;
+      ss << img_path << L"page" << (i + 1) << L".png";
+
+      // the image also depends on the rendering options
+      uint64_t fingerprint = 0;
+      if (fingerprint_store) {
+        fingerprint = hasher.GetFingerprint(page);
+        fingerprint = HashBytes(&zoom, sizeof(zoom), fingerprint);
+        fingerprint = HashBytes(&rotate, sizeof(rotate), fingerprint);
+        fingerprint = HashBytes(&clip_rect, sizeof(clip_rect), fingerprint);
+        fingerprint = HashBytes(&img_params.format, sizeof(img_params.format), fingerprint);
+        fingerprint = HashBytes(&img_params.quality, sizeof(img_params.quality), fingerprint);
+        std::string image_path;
+        if (fingerprint_store->Find(fingerprint, image_path) && copy_image(image_path, ss.str())) {
+          page->Release();
+          continue;
+        }
+      }
       PdfPageView* page_view = page->AcquirePageView(zoom, rotate);
       if (!page_view)
         throw PdfixException();
@@ -75,8 +135,6 @@ void RenderPages(
       if (!page->DrawContent(&params, nullptr, nullptr))
         throw PdfixException();
 
-      std::wstringstream ss;
-      ss << img_path << L"page" << (i + 1) << L".png";
       auto stream = pdfix->CreateFileStream(ss.str().c_str(), kPsTruncate);
       if (!stream)
         throw PdfixException();
@@ -84,6 +142,9 @@ void RenderPages(
         throw PdfixException();
       stream->Destroy();
 
+      std::string data;
+      if (fingerprint_store && read_file(ToUtf8(ss.str()), data))
+        fingerprint_store->Add(fingerprint, hash_data(data) + " " + ToUtf8(ss.str()));
       page->Release();
     }
   };
@@ -110,6 +171,9 @@ void RenderPages(
     w.join();
   }
 
+  if (fingerprint_store)
+    fingerprint_store->Report(std::cout);
+
   doc->Close();
 
   pdfix->Destroy();
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <functional>
+#include <vector>
 
 #include <locale>
 #include <codecvt>
@@ -17,25 +18,12 @@ using namespace PDFixSDK;
 
 namespace SearchText {
 
-  void DrawQuad(PdfDoc* doc, PdsContent* content, const PdfQuad& quad) {
+  // prepare graphic state shared by all highlights in the document
+  void InitHighlightState(PdfDoc* doc, PdfGraphicState& gs) {
     auto rgb_colorspace = doc->CreateColorSpace(PdfColorSpaceFamily::kColorSpaceDeviceRGB);
-
-    PdfMatrix matrix;
-    auto path_obj = content->AddNewPath(-1, &matrix);
-    if (!path_obj)
+    if (!rgb_colorspace)
       throw PdfixException();
 
-    path_obj->MoveTo(&quad.tl);
-    path_obj->LineTo(&quad.tr);
-    path_obj->LineTo(&quad.br);
-    path_obj->LineTo(&quad.bl);
-    path_obj->ClosePath();
-
-    path_obj->SetStroke(true);
-    path_obj->SetFillType(kFillRuleEvenOdd);
-
-    PdfGraphicState gs;
-    
     // red color
     auto color = rgb_colorspace->CreateColor();
     color->SetValue(0, 0.99f);
@@ -57,10 +45,86 @@ namespace SearchText {
     gs.line_cap = kPdfLineCapRound;
     gs.line_join = kPdfLineJoinRound;
     gs.blend_mode = kBlendModeNormal;
+  }
 
-    gs.matrix = matrix;
+  // draw all quads as subpaths of a single path object
+  void DrawQuads(PdsContent* content, const std::vector<PdfQuad>& quads, const PdfGraphicState& gs) {
+    if (quads.empty())
+      return;
 
-    path_obj->SetGState(&gs);
+    PdfMatrix matrix;
+    auto path_obj = content->AddNewPath(-1, &matrix);
+    if (!path_obj)
+      throw PdfixException();
+
+    // nonzero winding with all quads oriented the same way, overlapping hits don't cancel out
+    for (auto& quad : quads) {
+      const PdfPoint* points[4] = { &quad.tl, &quad.tr, &quad.br, &quad.bl };
+      double area = 0;
+      for (int i = 0; i < 4; i++) {
+        auto& p = *points[i];
+        auto& q = *points[(i + 1) % 4];
+        area += p.x * q.y - q.x * p.y;
+      }
+      if (area > 0)
+        std::swap(points[1], points[3]);
+      path_obj->MoveTo(points[0]);
+      path_obj->LineTo(points[1]);
+      path_obj->LineTo(points[2]);
+      path_obj->LineTo(points[3]);
+      path_obj->ClosePath();
+    }
+
+    path_obj->SetStroke(true);
+    path_obj->SetFillType(kFillRuleWinding);
+
+    auto path_gs = gs;
+    path_gs.matrix = matrix;
+    path_obj->SetGState(&path_gs);
+  }
+
+  // add a single highlight annotation covering all quads
+  void AddHighlightAnnot(PdfPage* page, const std::vector<PdfQuad>& quads) {
+    if (quads.empty())
+      return;
+
+    PdfRect rect;
+    rect.left = rect.right = quads.front().tl.x;
+    rect.bottom = rect.top = quads.front().tl.y;
+    for (auto& quad : quads) {
+      for (auto& pt : { quad.tl, quad.tr, quad.bl, quad.br }) {
+        rect.left = std::min(rect.left, pt.x);
+        rect.right = std::max(rect.right, pt.x);
+        rect.bottom = std::min(rect.bottom, pt.y);
+        rect.top = std::max(rect.top, pt.y);
+      }
+    }
+
+    auto annot = page->AddNewAnnot(-1, &rect, kAnnotHighlight);
+    if (!annot)
+      throw PdfixException();
+
+    annot->NotifyWillChange(L"QuadPoints");
+    auto annot_dict = annot->GetObject();
+
+    // quad points in the order top-left, top-right, bottom-left, bottom-right
+    auto quad_points = annot_dict->PutArray(L"QuadPoints");
+    int index = 0;
+    for (auto& quad : quads) {
+      for (auto& pt : { quad.tl, quad.tr, quad.bl, quad.br }) {
+        quad_points->PutNumber(index++, pt.x);
+        quad_points->PutNumber(index++, pt.y);
+      }
+    }
+
+    // red color
+    auto color = annot_dict->PutArray(L"C");
+    color->PutNumber(0, 0.99);
+    color->PutNumber(1, 0.33);
+    color->PutNumber(2, 0.33);
+
+    // notify after editing - this will regenerate the annotation appearance
+    annot->NotifyDidChange(L"QuadPoints", 0);
   }
 
   bool lower_test(wchar_t l, wchar_t r) {
@@ -118,7 +182,8 @@ namespace SearchText {
     const std::wstring& open_path,  // source PDF document
     const std::wstring& save_path,  // destination PDF document
     const std::wstring& query,      // text to search in pdf file
-    int page_num                    // number of the page where to search, -1 for all pages
+    int page_num,                   // number of the page where to search, -1 for all pages
+    HighlightMode mode              // highlight output mode
   ) {
     
     // initialize Pdfix
@@ -133,29 +198,48 @@ namespace SearchText {
     if (!doc)
       throw PdfixException();
 
-    PdfPage* page = nullptr;
+    PdfGraphicState gs;
+    if (mode != kHighlightAnnot)
+      InitHighlightState(doc, gs);
 
+    std::vector<PdfQuad> quads;
     auto process_word = [&](PdsWord* word) {
-      auto content = page->GetContent();
-      auto quad = word->GetQuad();      
-      DrawQuad(doc, content, quad);
+      quads.push_back(word->GetQuad());
     };
 
-    if (page_num < 0) {
-      auto page_count = doc->GetNumPages();
-      for (int i = 0; i < page_count; i++) {
-        page = doc->AcquirePage(i);
-        SearchText(page, query, process_word);
+    auto process_page = [&](int index) {
+      PdfPage* page = doc->AcquirePage(index);
+      if (!page)
+        throw PdfixException();
 
-        page->SetContent();
-        page->Release();
-      }
-    } else {
-      page = doc->AcquirePage(page_num);
+      quads.clear();
       SearchText(page, query, process_word);
 
-      page->SetContent();
+      if (!quads.empty()) {
+        switch (mode) {
+        case kHighlightPathPerHit:
+          for (auto& quad : quads)
+            DrawQuads(page->GetContent(), { quad }, gs);
+          page->SetContent();
+          break;
+        case kHighlightPagePath:
+          DrawQuads(page->GetContent(), quads, gs);
+          page->SetContent();
+          break;
+        case kHighlightAnnot:
+          AddHighlightAnnot(page, quads);
+          break;
+        }
+      }
       page->Release();
+    };
+
+    if (page_num < 0) {
+      auto page_count = doc->GetNumPages();
+      for (int i = 0; i < page_count; i++)
+        process_page(i);
+    } else {
+      process_page(page_num);
     }
 
     doc->Save(save_path.c_str(), kSaveFull);
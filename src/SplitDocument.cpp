@@ -0,0 +1,339 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// SplitDocument.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/SplitDocument.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <cstring>
+#include <algorithm>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace SplitDocument {
+
+  std::vector<Part> ParseRanges(const std::wstring& ranges, int num_pages, const std::wstring& save_dir) {
+    std::vector<Part> parts;
+    std::wstringstream input(ranges);
+    std::wstring token;
+    while (std::getline(input, token, L',')) {
+      token.erase(0, token.find_first_not_of(L" \t"));
+      token.erase(token.find_last_not_of(L" \t") + 1);
+      if (token.empty())
+        continue;
+
+      // "a-b", "a" or "a-" up to the last page
+      Part part;
+      size_t pos = 0;
+      try {
+        part.from = std::stoi(token, &pos) - 1;
+        part.to = part.from;
+        if (pos < token.length() && token[pos] == L'-') {
+          auto rest = token.substr(pos + 1);
+          part.to = rest.empty() ? num_pages - 1 : std::stoi(rest, &pos) - 1;
+          if (!rest.empty() && pos != rest.length())
+            throw std::invalid_argument("range");
+        }
+        else if (pos != token.length())
+          throw std::invalid_argument("range");
+      }
+      catch (std::logic_error&) {
+        throw std::runtime_error("Invalid page range " + ToUtf8(token));
+      }
+      if (part.from < 0 || part.from > part.to || part.to >= num_pages)
+        throw std::runtime_error("Page range out of document " + ToUtf8(token));
+
+      part.save_path = save_dir + L"/part" + std::to_wstring(parts.size() + 1) + L".pdf";
+      parts.push_back(part);
+    }
+    return parts;
+  }
+
+  void CollectNames(const uint8_t* data, size_t size, std::set<std::string>& names) {
+    auto is_white = [](uint8_t ch) {
+      return ch == 0 || ch == 9 || ch == 10 || ch == 12 || ch == 13 || ch == 32;
+    };
+    auto is_delimiter = [](uint8_t ch) { return ch != 0 && strchr("()<>[]{}/%", ch) != nullptr; };
+    auto hex_value = [](uint8_t ch) {
+      if (ch >= '0' && ch <= '9')
+        return ch - '0';
+      if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+      if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+      return -1;
+    };
+
+    size_t i = 0;
+    while (i < size) {
+      uint8_t ch = data[i];
+      if (is_white(ch)) {
+        i++;
+      }
+      else if (ch == '%') {
+        while (i < size && data[i] != '\r' && data[i] != '\n')
+          i++;
+      }
+      else if (ch == '(') {
+        // literal string with balanced parentheses and escapes
+        int depth = 0;
+        for (; i < size; i++) {
+          if (data[i] == '\\')
+            i++;
+          else if (data[i] == '(')
+            depth++;
+          else if (data[i] == ')' && --depth == 0) {
+            i++;
+            break;
+          }
+        }
+      }
+      else if (ch == '<' && i + 1 < size && data[i + 1] == '<') {
+        // inline dictionary of marked content properties
+        i += 2;
+      }
+      else if (ch == '<') {
+        // hex string
+        while (i < size && data[i] != '>')
+          i++;
+        i++;
+      }
+      else if (ch == '/') {
+        std::string name;
+        for (i++; i < size && !is_white(data[i]) && !is_delimiter(data[i]); i++) {
+          if (data[i] == '#' && i + 2 < size && hex_value(data[i + 1]) >= 0 && hex_value(data[i + 2]) >= 0) {
+            name += (char)(hex_value(data[i + 1]) * 16 + hex_value(data[i + 2]));
+            i += 2;
+          }
+          else
+            name += (char)data[i];
+        }
+        names.insert(name);
+      }
+      else if (is_delimiter(ch)) {
+        i++;
+      }
+      else {
+        size_t start = i;
+        while (i < size && !is_white(data[i]) && !is_delimiter(data[i]))
+          i++;
+        if (i - start == 2 && data[start] == 'I' && data[start + 1] == 'D') {
+          // inline image data is binary, it ends with EI enclosed in white space
+          for (i += 2; i + 1 < size; i++) {
+            if (is_white(data[i - 1]) && data[i] == 'E' && data[i + 1] == 'I' &&
+              (i + 2 == size || is_white(data[i + 2])))
+              break;
+          }
+          i += 2;
+        }
+      }
+    }
+  }
+
+  // reads all content streams of the page, returns false when any of them can't be read
+  static bool ReadPageContent(PdsDictionary* page_dict, std::vector<uint8_t>& data) {
+    std::vector<PdsStream*> streams;
+    auto contents = page_dict->Get(L"Contents");
+    if (contents && contents->GetObjectType() == kPdsStream)
+      streams.push_back((PdsStream*)contents);
+    else if (contents && contents->GetObjectType() == kPdsArray) {
+      auto contents_array = (PdsArray*)contents;
+      for (int i = 0; i < contents_array->GetNumObjects(); i++) {
+        auto stream = contents_array->GetStream(i);
+        if (!stream)
+          return false;
+        streams.push_back(stream);
+      }
+    }
+    else if (contents)
+      return false;
+
+    data.clear();
+    for (auto stream : streams) {
+      auto offset = data.size();
+      data.resize(offset + stream->GetSize());
+      if (data.size() > offset && !stream->Read(0, data.data() + offset, (int)(data.size() - offset)))
+        return false;
+      // streams are concatenated, tokens must not join across them
+      data.push_back('\n');
+    }
+    return true;
+  }
+
+  size_t PruneResources(PdfDoc* doc, size_t thread_count) {
+    static const wchar_t* categories[] = {
+      L"XObject", L"Font", L"ExtGState", L"ColorSpace", L"Pattern", L"Shading", L"Properties" };
+
+    // names used by each page are collected in parallel, the document is only read
+    auto num_pages = doc->GetNumPages();
+    std::vector<std::set<std::string>> page_names(num_pages);
+    std::vector<char> readable(num_pages, 0);
+    auto collect_names = [&](int from, int to) {
+      std::vector<uint8_t> data;
+      for (int i = from; i <= to; i++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        if (!ReadPageContent(page->GetObject(), data))
+          continue;
+        CollectNames(data.data(), data.size(), page_names[i]);
+        readable[i] = 1;
+      }
+    };
+    ParallelFor(0, num_pages - 1, thread_count, collect_names);
+
+    size_t pruned = 0;
+    for (int i = 0; i < num_pages; i++) {
+      if (!readable[i])
+        continue;
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+
+      // resources may be inherited from the page tree
+      auto page_dict = page->GetObject();
+      PdsDictionary* resources = nullptr;
+      for (auto dict = page_dict; dict && !resources; dict = dict->GetDictionary(L"Parent"))
+        resources = dict->GetDictionary(L"Resources");
+      if (!resources)
+        continue;
+
+      // direct entries can't be referred from a second dictionary, such pages are kept as they are
+      bool shareable = true;
+      for (auto category : categories) {
+        auto category_dict = resources->GetDictionary(category);
+        for (int j = 0; category_dict && j < category_dict->GetNumKeys(); j++) {
+          auto key = category_dict->GetKey(j);
+          auto object = category_dict->Get(key.c_str());
+          if (object && object->GetId() == 0)
+            shareable = false;
+        }
+      }
+      if (!shareable)
+        continue;
+
+      auto& names = page_names[i];
+      auto page_resources = doc->CreateDictObject(true);
+      if (!page_resources)
+        throw PdfixException();
+      size_t page_pruned = 0;
+      for (int j = 0; j < resources->GetNumKeys(); j++) {
+        auto key = resources->GetKey(j);
+        auto is_category = std::find_if(std::begin(categories), std::end(categories),
+          [&](const wchar_t* category) { return key == category; }) != std::end(categories);
+        auto category_dict = is_category ? resources->GetDictionary(key.c_str()) : nullptr;
+        if (!category_dict) {
+          // ProcSet and other entries, direct ones are obsolete procedure set names
+          auto object = resources->Get(key.c_str());
+          if (object && object->GetId() != 0)
+            page_resources->Put(key.c_str(), object);
+          continue;
+        }
+
+        auto page_category = page_resources->PutDict(key.c_str());
+        if (!page_category)
+          throw PdfixException();
+        for (int k = 0; k < category_dict->GetNumKeys(); k++) {
+          auto name = category_dict->GetKey(k);
+          // names out of ASCII may be spelled differently in the content, they are kept
+          bool ascii = std::all_of(name.begin(), name.end(), [](wchar_t ch) { return ch < 0x80; });
+          if (ascii && !names.count(ToUtf8(name))) {
+            page_pruned++;
+            continue;
+          }
+          if (!page_category->Put(name.c_str(), category_dict->Get(name.c_str())))
+            throw PdfixException();
+        }
+      }
+      if (!page_dict->Put(L"Resources", page_resources))
+        throw PdfixException();
+      pruned += page_pruned;
+    }
+    return pruned;
+  }
+
+  void Split(
+    PdfDoc* doc,                          // source document
+    const std::vector<Part>& parts,       // page ranges and output paths
+    PdfSaveFlags save_flags,              // flags used to save every part
+    size_t thread_count,                  // max number of threads
+    Stats& stats                          // split statistics
+  ) {
+    Pdfix* pdfix = GetPdfix();
+    auto clock_start = std::chrono::steady_clock::now();
+
+    stats.pruned = PruneResources(doc, thread_count);
+
+    // copying reads objects of the shared source, saving works on the part only
+    std::mutex source_mutex;
+    std::atomic<size_t> page_count(0);
+    auto write_parts = [&](int from, int to) {
+      for (int i = from; i <= to; i++) {
+        auto& part = parts[i];
+        auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+        std::unique_ptr<PdfDoc, decltype(doc_deleter)> part_doc(pdfix->CreateDoc(), doc_deleter);
+        if (!part_doc)
+          throw PdfixException();
+        {
+          std::lock_guard<std::mutex> lock(source_mutex);
+          if (!part_doc->InsertPages(0, doc, part.from, part.to, kInsertNone, nullptr, nullptr))
+            throw PdfixException();
+        }
+        if (!part_doc->Save(part.save_path.c_str(), save_flags))
+          throw PdfixException();
+        page_count += part.to - part.from + 1;
+      }
+    };
+    ParallelFor(0, (int)parts.size() - 1, thread_count, write_parts);
+
+    auto clock_end = std::chrono::steady_clock::now();
+    stats.parts = parts.size();
+    stats.pages = page_count;
+    stats.seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+  }
+
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    const std::wstring& ranges,           // 1-based page ranges separated by commas
+    const std::wstring& save_dir,         // output directory
+    size_t thread_count,                  // max number of threads
+    std::ostream& output                  // output stream for the report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    auto parts = ParseRanges(ranges, doc->GetNumPages(), save_dir);
+    Stats stats;
+    Split(doc, parts, kSaveFull, thread_count, stats);
+
+    output << "parts: " << stats.parts << ", pages: " << stats.pages << ", pruned resources: "
+      << stats.pruned << std::endl;
+    output << "split in " << stats.seconds << " s";
+    if (stats.seconds > 0)
+      output << " (" << stats.pages / stats.seconds << " pages/s)";
+    output << std::endl;
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+} // namespace SplitDocument
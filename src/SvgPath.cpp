@@ -0,0 +1,511 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// SvgPath.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/SvgPath.h"
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cwchar>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace SvgPath {
+
+  void PdsPathSink::MoveTo(const PdfPoint& pt) {
+    if (!m_path->MoveTo(&pt))
+      throw PdfixException();
+  }
+
+  void PdsPathSink::LineTo(const PdfPoint& pt) {
+    if (!m_path->LineTo(&pt))
+      throw PdfixException();
+  }
+
+  void PdsPathSink::CurveTo(const PdfPoint& cp1, const PdfPoint& cp2, const PdfPoint& pt) {
+    if (!m_path->CurveTo(&cp1, &cp2, &pt))
+      throw PdfixException();
+  }
+
+  void PdsPathSink::ArcTo(const PdfPoint& radius, double x_angle, bool large, bool sweep, const PdfPoint& pt) {
+    if (!m_path->ArcTo(&pt, &radius, x_angle, large, sweep))
+      throw PdfixException();
+  }
+
+  void PdsPathSink::ClosePath() {
+    if (!m_path->ClosePath())
+      throw PdfixException();
+  }
+
+  static bool IsDigit(wchar_t ch) {
+    return ch >= L'0' && ch <= L'9';
+  }
+
+  static bool IsNumberStart(wchar_t ch) {
+    return IsDigit(ch) || ch == L'.' || ch == L'-' || ch == L'+';
+  }
+
+  // skips white space and commas between numbers and commands
+  static void SkipSeparators(const wchar_t*& pos, const wchar_t* end) {
+    while (pos < end && (*pos == L' ' || *pos == L',' || *pos == L'\t' || *pos == L'\n' ||
+      *pos == L'\r' || *pos == L'\f'))
+      pos++;
+  }
+
+  // mantissa * 10^exponent, exact powers of ten keep the result correctly rounded for typical input
+  static double Scale(uint64_t mantissa, int exponent) {
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    double value = (double)mantissa;
+    if (exponent == 0 || mantissa == 0)
+      return value;
+    if (exponent > 0 && exponent <= 22)
+      return value * pow10[exponent];
+    if (exponent < 0 && exponent >= -22)
+      return value / pow10[-exponent];
+    return value * std::pow(10., exponent);
+  }
+
+  // number: sign? (digits ('.' digits?)? | '.' digits) (('e' | 'E') sign? digits)?
+  static bool ReadNumber(const wchar_t*& pos, const wchar_t* end, double& value) {
+    SkipSeparators(pos, end);
+    const wchar_t* p = pos;
+    bool negative = false;
+    if (p < end && (*p == L'+' || *p == L'-')) {
+      negative = *p == L'-';
+      p++;
+    }
+
+    // up to 19 significant digits fit the integer mantissa, the rest only moves the exponent
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    for (; p < end && IsDigit(*p); p++) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - L'0');
+        if (mantissa)
+          digits++;
+      }
+      else
+        exponent++;
+      has_digits = true;
+    }
+    if (p < end && *p == L'.') {
+      p++;
+      for (; p < end && IsDigit(*p); p++) {
+        if (digits < 19) {
+          mantissa = mantissa * 10 + (*p - L'0');
+          if (mantissa)
+            digits++;
+          exponent--;
+        }
+        has_digits = true;
+      }
+    }
+    if (!has_digits)
+      return false;
+
+    if (p < end && (*p == L'e' || *p == L'E')) {
+      const wchar_t* q = p + 1;
+      bool exp_negative = false;
+      if (q < end && (*q == L'+' || *q == L'-')) {
+        exp_negative = *q == L'-';
+        q++;
+      }
+      if (q < end && IsDigit(*q)) {
+        int exp_value = 0;
+        for (; q < end && IsDigit(*q); q++) {
+          if (exp_value < 10000)
+            exp_value = exp_value * 10 + (*q - L'0');
+        }
+        exponent += exp_negative ? -exp_value : exp_value;
+        p = q;
+      }
+    }
+
+    value = Scale(mantissa, exponent);
+    if (negative)
+      value = -value;
+    pos = p;
+    return true;
+  }
+
+  static bool ReadPoint(const wchar_t*& pos, const wchar_t* end, const PdfPoint& origin, PdfPoint& pt) {
+    if (!ReadNumber(pos, end, pt.x) || !ReadNumber(pos, end, pt.y))
+      return false;
+    pt.x += origin.x;
+    pt.y += origin.y;
+    return true;
+  }
+
+  // arc flags are single characters and may be written without separators
+  static bool ReadFlag(const wchar_t*& pos, const wchar_t* end, bool& flag) {
+    SkipSeparators(pos, end);
+    if (pos == end || (*pos != L'0' && *pos != L'1'))
+      return false;
+    flag = *pos++ == L'1';
+    return true;
+  }
+
+  static PdfPoint Reflect(const PdfPoint& ctrl, const PdfPoint& center) {
+    PdfPoint pt;
+    pt.x = 2 * center.x - ctrl.x;
+    pt.y = 2 * center.y - ctrl.y;
+    return pt;
+  }
+
+  // control point of a cubic curve equivalent to a quadratic one
+  static PdfPoint QuadToCubic(const PdfPoint& end, const PdfPoint& ctrl) {
+    PdfPoint pt;
+    pt.x = end.x + 2. / 3. * (ctrl.x - end.x);
+    pt.y = end.y + 2. / 3. * (ctrl.y - end.y);
+    return pt;
+  }
+
+  bool Parse(const wchar_t* data, size_t length, PathSink& sink) {
+    const wchar_t* pos = data;
+    const wchar_t* end = data + length;
+
+    PdfPoint current = { 0, 0 };        // current point
+    PdfPoint start = { 0, 0 };          // start of the current subpath
+    PdfPoint ctrl = { 0, 0 };           // last control point, reflected by S and T
+    wchar_t cmd = 0;                    // command applied to the next arguments
+    wchar_t last = 0;                   // upper case letter of the last emitted segment
+
+    while (true) {
+      SkipSeparators(pos, end);
+      if (pos == end)
+        return true;
+
+      if (IsNumberStart(*pos)) {
+        // implicit repetition of the previous command
+        if (cmd == 0 || cmd == L'Z' || cmd == L'z')
+          return false;
+      }
+      else {
+        cmd = *pos++;
+        if (last == 0 && cmd != L'M' && cmd != L'm')
+          return false;
+      }
+
+      bool relative = cmd >= L'a';
+      PdfPoint origin = { 0, 0 };
+      if (relative)
+        origin = current;
+
+      PdfPoint pt;
+      switch (cmd) {
+      case L'M':
+      case L'm':
+        if (!ReadPoint(pos, end, origin, pt))
+          return false;
+        sink.MoveTo(pt);
+        start = pt;
+        // following coordinate pairs are line segments
+        cmd = relative ? L'l' : L'L';
+        last = L'M';
+        break;
+      case L'L':
+      case L'l':
+        if (!ReadPoint(pos, end, origin, pt))
+          return false;
+        sink.LineTo(pt);
+        last = L'L';
+        break;
+      case L'H':
+      case L'h':
+        if (!ReadNumber(pos, end, pt.x))
+          return false;
+        pt.x += origin.x;
+        pt.y = current.y;
+        sink.LineTo(pt);
+        last = L'L';
+        break;
+      case L'V':
+      case L'v':
+        if (!ReadNumber(pos, end, pt.y))
+          return false;
+        pt.x = current.x;
+        pt.y += origin.y;
+        sink.LineTo(pt);
+        last = L'L';
+        break;
+      case L'C':
+      case L'c': {
+        PdfPoint cp1, cp2;
+        if (!ReadPoint(pos, end, origin, cp1) || !ReadPoint(pos, end, origin, cp2) ||
+          !ReadPoint(pos, end, origin, pt))
+          return false;
+        sink.CurveTo(cp1, cp2, pt);
+        ctrl = cp2;
+        last = L'C';
+        break;
+      }
+      case L'S':
+      case L's': {
+        PdfPoint cp1 = last == L'C' ? Reflect(ctrl, current) : current;
+        PdfPoint cp2;
+        if (!ReadPoint(pos, end, origin, cp2) || !ReadPoint(pos, end, origin, pt))
+          return false;
+        sink.CurveTo(cp1, cp2, pt);
+        ctrl = cp2;
+        last = L'C';
+        break;
+      }
+      case L'Q':
+      case L'q': {
+        PdfPoint q;
+        if (!ReadPoint(pos, end, origin, q) || !ReadPoint(pos, end, origin, pt))
+          return false;
+        sink.CurveTo(QuadToCubic(current, q), QuadToCubic(pt, q), pt);
+        ctrl = q;
+        last = L'Q';
+        break;
+      }
+      case L'T':
+      case L't': {
+        PdfPoint q = last == L'Q' ? Reflect(ctrl, current) : current;
+        if (!ReadPoint(pos, end, origin, pt))
+          return false;
+        sink.CurveTo(QuadToCubic(current, q), QuadToCubic(pt, q), pt);
+        ctrl = q;
+        last = L'Q';
+        break;
+      }
+      case L'A':
+      case L'a': {
+        PdfPoint radius;
+        double x_angle;
+        bool large, sweep;
+        if (!ReadNumber(pos, end, radius.x) || !ReadNumber(pos, end, radius.y) ||
+          !ReadNumber(pos, end, x_angle) || !ReadFlag(pos, end, large) || !ReadFlag(pos, end, sweep) ||
+          !ReadPoint(pos, end, origin, pt))
+          return false;
+        // out of range parameters as defined in the SVG implementation notes
+        radius.x = std::fabs(radius.x);
+        radius.y = std::fabs(radius.y);
+        if (pt.x == current.x && pt.y == current.y) {
+          last = L'A';
+          continue;
+        }
+        if (radius.x == 0 || radius.y == 0)
+          sink.LineTo(pt);
+        else
+          sink.ArcTo(radius, x_angle, large, sweep, pt);
+        last = L'A';
+        break;
+      }
+      case L'Z':
+      case L'z':
+        sink.ClosePath();
+        pt = start;
+        last = L'Z';
+        break;
+      default:
+        return false;
+      }
+      current = pt;
+    }
+  }
+
+  bool Parse(const std::wstring& data, PathSink& sink) {
+    return Parse(data.c_str(), data.length(), sink);
+  }
+
+  // appends a number, the separator is omitted before a minus sign like in minified SVG
+  static void AppendNumber(double value, bool separator, std::wstring& data) {
+    wchar_t buffer[32];
+    swprintf(buffer, 32, L"%.2f", value);
+    std::wstring number = buffer;
+    number.erase(number.find_last_not_of(L'0') + 1);
+    if (number.back() == L'.')
+      number.pop_back();
+    if (number == L"-0")
+      number = L"0";
+    if (separator && number[0] != L'-')
+      data += L' ';
+    data += number;
+  }
+
+  void CreateIconPaths(size_t count, std::vector<std::wstring>& paths) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> coord(0, 24);
+    std::uniform_real_distribution<double> delta(-6, 6);
+    std::uniform_int_distribution<int> command(0, 7);
+    const wchar_t* commands = L"LlHhVvCcSsQqTtAa";
+
+    for (size_t i = 0; i < count; i++) {
+      std::wstring data = L"M";
+      AppendNumber(coord(random), false, data);
+      AppendNumber(coord(random), true, data);
+      for (int j = 0; j < 24; j++) {
+        int index = command(random);
+        bool relative = random() % 2 == 1;
+        wchar_t cmd = commands[index * 2 + (relative ? 1 : 0)];
+        auto value = [&]() { return relative ? delta(random) : coord(random); };
+        data += cmd;
+        int args = 0;
+        switch (index) {
+        case 0: case 6: args = 2; break;   // L, T
+        case 1: case 2: args = 1; break;   // H, V
+        case 3: args = 6; break;           // C
+        case 4: case 5: args = 4; break;   // S, Q
+        case 7:                            // A
+          AppendNumber(1 + std::fabs(delta(random)), false, data);
+          AppendNumber(1 + std::fabs(delta(random)), true, data);
+          data += L" 0 ";
+          data += random() % 2 ? L'1' : L'0';
+          data += random() % 2 ? L'1' : L'0';
+          AppendNumber(value(), true, data);
+          AppendNumber(value(), true, data);
+          break;
+        }
+        for (int k = 0; k < args; k++)
+          AppendNumber(value(), k > 0, data);
+      }
+      data += L'z';
+      paths.push_back(data);
+    }
+  }
+
+  void CreateMapPaths(size_t count, size_t segments, std::vector<std::wstring>& paths) {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> coord(0, 1000);
+    std::uniform_real_distribution<double> delta(-3, 3);
+
+    for (size_t i = 0; i < count; i++) {
+      std::wstring data = L"M";
+      AppendNumber(coord(random), false, data);
+      AppendNumber(coord(random), true, data);
+      data += L'l';
+      for (size_t j = 0; j < segments; j++) {
+        AppendNumber(delta(random), j > 0, data);
+        AppendNumber(delta(random), true, data);
+      }
+      paths.push_back(data);
+    }
+  }
+
+  void LoadPaths(const std::wstring& path, std::vector<std::wstring>& paths) {
+    std::ifstream ifs(ToUtf8(path));
+    if (!ifs)
+      throw std::runtime_error("Cannot open " + ToUtf8(path));
+    std::string line;
+    while (std::getline(ifs, line)) {
+      if (!line.empty())
+        paths.push_back(FromUtf8(line));
+    }
+  }
+
+  // counts segments, the checksum keeps the parsing from being optimized away
+  class CountingSink : public PathSink {
+  public:
+    size_t segments = 0;
+    double checksum = 0;
+    void MoveTo(const PdfPoint& pt) override { Add(pt); }
+    void LineTo(const PdfPoint& pt) override { Add(pt); }
+    void CurveTo(const PdfPoint&, const PdfPoint&, const PdfPoint& pt) override { Add(pt); }
+    void ArcTo(const PdfPoint&, double, bool, bool, const PdfPoint& pt) override { Add(pt); }
+    void ClosePath() override { segments++; }
+
+  private:
+    void Add(const PdfPoint& pt) {
+      segments++;
+      checksum += pt.x + pt.y;
+    }
+  };
+
+  // stream tokenizer of the former CreatePathFromSvg, returns false for tokens it did not understand
+  static bool TokenizeLegacy(const std::wstring& data, double& checksum) {
+    std::wistringstream iss(data);
+    std::istream_iterator<std::wstring, wchar_t, std::char_traits<wchar_t>> it(iss);
+    auto end = std::istream_iterator<std::wstring, wchar_t, std::char_traits<wchar_t>>();
+    bool supported = true;
+    for (; it != end; ++it) {
+      auto& token = *it;
+      if (token == L"M" || token == L"L" || token == L"C" || token == L"A" || token == L"Z")
+        continue;
+      try {
+        size_t length = 0;
+        checksum += std::stod(token, &length);
+        if (length != token.length())
+          supported = false;
+      }
+      catch (std::exception&) {
+        supported = false;
+      }
+    }
+    return supported;
+  }
+
+  void Benchmark(const std::string& name, const std::vector<std::wstring>& paths, std::ostream& output) {
+    size_t chars = 0;
+    for (auto& data : paths)
+      chars += data.length();
+    double megabytes = chars / 1e6;
+
+    auto clock_start = std::chrono::steady_clock::now();
+    CountingSink sink;
+    size_t failed = 0;
+    for (auto& data : paths) {
+      if (!Parse(data, sink))
+        failed++;
+    }
+    auto clock_end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+
+    clock_start = std::chrono::steady_clock::now();
+    double legacy_checksum = 0;
+    size_t legacy_failed = 0;
+    for (auto& data : paths) {
+      if (!TokenizeLegacy(data, legacy_checksum))
+        legacy_failed++;
+    }
+    clock_end = std::chrono::steady_clock::now();
+    double legacy_seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+
+    output << name << ": " << paths.size() << " paths, " << megabytes << " M chars, "
+      << sink.segments << " segments" << std::endl;
+    output << "  parser: " << seconds << " s";
+    if (seconds > 0)
+      output << " (" << megabytes / seconds << " M chars/s, " << sink.segments / seconds << " segments/s)";
+    output << ", failed paths: " << failed << std::endl;
+    output << "  stream tokenizer: " << legacy_seconds << " s";
+    if (legacy_seconds > 0)
+      output << " (" << megabytes / legacy_seconds << " M chars/s)";
+    output << ", unsupported paths: " << legacy_failed << std::endl;
+    if (seconds > 0)
+      output << "  speedup: " << legacy_seconds / seconds << std::endl;
+  }
+
+  void Run(
+    const std::vector<std::wstring>& dataset_paths,  // datasets to benchmark, sample datasets if empty
+    std::ostream& output                             // output stream for the report
+  ) {
+    if (dataset_paths.empty()) {
+      std::vector<std::wstring> paths;
+      CreateIconPaths(20000, paths);
+      Benchmark("icons", paths, output);
+      paths.clear();
+      CreateMapPaths(200, 5000, paths);
+      Benchmark("map", paths, output);
+      return;
+    }
+    for (auto& dataset_path : dataset_paths) {
+      std::vector<std::wstring> paths;
+      LoadPaths(dataset_path, paths);
+      Benchmark(ToUtf8(dataset_path), paths, output);
+    }
+  }
+} // namespace SvgPath
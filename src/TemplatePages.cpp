@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// TemplatePages.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/TemplatePages.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include "pdfixsdksamples/BatchStamping.h"
+#include "pdfixsdksamples/DocumentGenerator.h"
+#include "pdfixsdksamples/EditContent.h"
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace TemplatePages {
+
+  PageTemplate::PageTemplate(PdfDoc* doc, PdfPage* template_page)
+    : m_doc(doc), m_writer(doc) {
+    m_media_box = template_page->GetCropBox();
+
+    // the template content and resources are copied into the document once
+    auto xobj = doc->CreateXObjectFromPage(template_page);
+    if (!xobj)
+      throw PdfixException();
+
+    m_resources = doc->CreateDictObject(true);
+    if (!m_resources)
+      throw PdfixException();
+    auto xobjects = m_resources->PutDict(L"XObject");
+    if (!xobjects || !xobjects->Put(L"PdfixTpl", xobj))
+      throw PdfixException();
+
+    std::string operators = "/PdfixTpl Do\n";
+    auto content_dict = doc->CreateDictObject(false);
+    if (!content_dict)
+      throw PdfixException();
+    m_content = doc->CreateStreamObject(true, content_dict, (const uint8_t*)operators.data(),
+      (int)operators.size());
+    if (!m_content)
+      throw PdfixException();
+
+    // standard font, nothing is embedded
+    m_font = doc->CreateDictObject(true);
+    if (!m_font)
+      throw PdfixException();
+    m_font->PutName(L"Type", L"Font");
+    m_font->PutName(L"Subtype", L"Type1");
+    m_font->PutName(L"BaseFont", L"Helvetica");
+    m_font->PutName(L"Encoding", L"WinAnsiEncoding");
+  }
+
+  void PageTemplate::AddPage(const std::vector<Field>& fields) {
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::unique_ptr<PdfPage, decltype(page_deleter)>
+      page(m_doc->CreatePage(-1, &m_media_box), page_deleter);
+    if (!page)
+      throw PdfixException();
+
+    // the clone refers to the shared objects, nothing of the template is copied
+    auto page_dict = page->GetObject();
+    if (!page_dict->Put(L"Contents", m_content) || !page_dict->Put(L"Resources", m_resources))
+      throw PdfixException();
+    if (fields.empty())
+      return;
+
+    // the font is registered in the shared resources with the first field
+    std::string operators;
+    for (auto& field : fields) {
+      m_writer.DrawText(page.get(), m_font, field.font_size, field.pos,
+        BatchStamping::EncodeWinAnsi(field.text), 1.f, operators);
+    }
+    m_writer.Write(page.get(), operators, ContentOverlay::kLayerOverlay);
+  }
+
+  void Generate(
+    const std::wstring& template_path,    // PDF document with the template page
+    int page_num,                         // template page number
+    const std::wstring& save_dir,         // output directory
+    size_t document_count,                // number of documents to create
+    size_t pages_per_document,            // number of cloned pages in each document
+    const FieldsProc& fill,               // fields of each copy
+    size_t thread_count,                  // max number of threads
+    Stats& stats                          // creation statistics
+  ) {
+    Pdfix* pdfix = GetPdfix();
+
+    auto clock_start = std::chrono::steady_clock::now();
+    auto generate_docs = [&](int from, int to) {
+      auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+      std::unique_ptr<PdfDoc, decltype(doc_deleter)>
+        template_doc(pdfix->OpenDoc(template_path.c_str(), L""), doc_deleter);
+      if (!template_doc)
+        throw PdfixException();
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)>
+        template_page(template_doc->AcquirePage(page_num), page_deleter);
+      if (!template_page)
+        throw PdfixException();
+
+      std::vector<Field> fields;
+      for (int i = from; i <= to; i++) {
+        std::unique_ptr<PdfDoc, decltype(doc_deleter)> doc(pdfix->CreateDoc(), doc_deleter);
+        if (!doc)
+          throw PdfixException();
+
+        PageTemplate page_template(doc.get(), template_page.get());
+        for (size_t j = 0; j < pages_per_document; j++) {
+          fields.clear();
+          if (fill)
+            fill(i * pages_per_document + j, fields);
+          page_template.AddPage(fields);
+        }
+
+        if (save_dir.empty()) {
+          auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+          std::unique_ptr<PsStream, decltype(stm_deleter)> stm(pdfix->CreateMemStream(), stm_deleter);
+          if (!stm)
+            throw PdfixException();
+          if (!doc->SaveToStream(stm.get(), kSaveFull))
+            throw PdfixException();
+        }
+        else {
+          std::wstringstream ss;
+          ss << save_dir << L"/document" << i << L".pdf";
+          if (!doc->Save(ss.str().c_str(), kSaveFull))
+            throw PdfixException();
+        }
+      }
+    };
+    ParallelFor(0, (int)document_count - 1, thread_count, generate_docs);
+
+    auto clock_end = std::chrono::steady_clock::now();
+    stats.documents = document_count;
+    stats.pages = document_count * pages_per_document;
+    stats.seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+  }
+
+  void Run(
+    const std::wstring& template_path,    // PDF document with the letter design on the first page
+    const std::wstring& save_dir,         // output directory
+    size_t document_count,                // number of documents to create
+    size_t pages_per_document,            // number of letters in each document
+    size_t thread_count                   // max number of threads
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    auto fill = [](size_t copy_index, std::vector<Field>& fields) {
+      Field recipient;
+      recipient.pos.x = 72;
+      recipient.pos.y = 720;
+      recipient.text = L"Recipient " + std::to_wstring(copy_index + 1);
+      fields.push_back(recipient);
+
+      Field reference = recipient;
+      reference.pos.y -= 16;
+      reference.text = L"Reference " + std::to_wstring(100000 + copy_index);
+      fields.push_back(reference);
+    };
+    Stats stats;
+    Generate(template_path, 0, save_dir, document_count, pages_per_document, fill, thread_count, stats);
+
+    pdfix->Destroy();
+  }
+
+  void Benchmark(
+    const std::wstring& logo_path,        // logo image placed on the invoice
+    size_t page_count,                    // number of copies
+    std::ostream& output                  // output stream for the report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfRect media_box;
+    media_box.left = 0;
+    media_box.bottom = 0;
+    media_box.right = 595;
+    media_box.top = 842;
+
+    auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    EditContent::PropsBuilder builder;
+
+    auto report = [&](const char* name, PdfDoc* doc, double seconds) {
+      auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+      std::unique_ptr<PsStream, decltype(stm_deleter)> stm(pdfix->CreateMemStream(), stm_deleter);
+      if (!stm)
+        throw PdfixException();
+      if (!doc->SaveToStream(stm.get(), kSaveFull))
+        throw PdfixException();
+      output << name << ": " << page_count << " pages in " << seconds << " s";
+      if (seconds > 0)
+        output << " (" << page_count / seconds << " pages/s)";
+      output << ", " << stm->GetSize() / 1024 << " KB" << std::endl;
+      return seconds;
+    };
+
+    // every copy is built from objects, resources are shared through the cache
+    double rebuild_seconds = 0;
+    {
+      auto clock_start = std::chrono::steady_clock::now();
+      std::unique_ptr<PdfDoc, decltype(doc_deleter)> doc(pdfix->CreateDoc(), doc_deleter);
+      if (!doc)
+        throw PdfixException();
+      EditContent::ResourceCache cache(pdfix, doc.get());
+      for (size_t i = 0; i < page_count; i++) {
+        builder.Clear();
+        DocumentGenerator::BuildInvoice(logo_path, i, builder);
+        std::unique_ptr<PdfPage, decltype(page_deleter)>
+          page(doc->CreatePage(-1, &media_box), page_deleter);
+        if (!page)
+          throw PdfixException();
+        EditContent::EditPageContent(cache, page->GetContent(), builder.Get());
+        if (!page->SetContent())
+          throw PdfixException();
+      }
+      auto clock_end = std::chrono::steady_clock::now();
+      rebuild_seconds = report("rebuilt pages", doc.get(),
+        std::chrono::duration<double>(clock_end - clock_start).count());
+    }
+
+    // images and paths of the invoice form the template, texts are the fields of each copy
+    double clone_seconds = 0;
+    {
+      auto clock_start = std::chrono::steady_clock::now();
+      builder.Clear();
+      DocumentGenerator::BuildInvoice(logo_path, 0, builder);
+      std::vector<EditContent::ObjectProps> design;
+      for (auto& props : builder.Get()) {
+        if (props.obj_type != kPdsPageText)
+          design.push_back(props);
+      }
+      std::unique_ptr<PdfDoc, decltype(doc_deleter)>
+        template_doc(DocumentGenerator::CreateDocument(pdfix, design, media_box, true), doc_deleter);
+      std::unique_ptr<PdfPage, decltype(page_deleter)>
+        template_page(template_doc->AcquirePage(0), page_deleter);
+      if (!template_page)
+        throw PdfixException();
+
+      std::unique_ptr<PdfDoc, decltype(doc_deleter)> doc(pdfix->CreateDoc(), doc_deleter);
+      if (!doc)
+        throw PdfixException();
+      PageTemplate page_template(doc.get(), template_page.get());
+      std::vector<Field> fields;
+      for (size_t i = 0; i < page_count; i++) {
+        builder.Clear();
+        DocumentGenerator::BuildInvoice(logo_path, i, builder);
+        fields.clear();
+        for (auto& props : builder.Get()) {
+          if (props.obj_type != kPdsPageText)
+            continue;
+          Field field;
+          field.pos = props.pos;
+          field.font_size = 20;
+          field.text = props.data;
+          fields.push_back(field);
+        }
+        page_template.AddPage(fields);
+      }
+      auto clock_end = std::chrono::steady_clock::now();
+      clone_seconds = report("cloned pages", doc.get(),
+        std::chrono::duration<double>(clock_end - clock_start).count());
+    }
+
+    if (clone_seconds > 0)
+      output << "speedup: " << rebuild_seconds / clone_seconds << std::endl;
+
+    pdfix->Destroy();
+  }
+} // namespace TemplatePages
@@ -0,0 +1,318 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// TextChunks.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/TextChunks.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <cwctype>
+#include <boost/property_tree/json_parser.hpp>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+using namespace boost::property_tree;
+
+namespace TextChunks {
+
+  static int GetHeadingLevel(PdfTextStyle style) {
+    switch (style) {
+    case kTextTitle: return 1;
+    case kTextH1: return 1;
+    case kTextH2: return 2;
+    case kTextH3: return 3;
+    case kTextH4: return 4;
+    case kTextH5: return 5;
+    case kTextH6: return 6;
+    case kTextH7: return 7;
+    case kTextH8: return 8;
+    default: return 0;
+    }
+  }
+
+  static void GetElementBlocks(PdeElement* element, int page_num, std::vector<Block>& blocks) {
+    switch (element->GetType()) {
+    case kPdeHeader:
+    case kPdeFooter:
+      return;
+    case kPdeText: {
+      auto text = (PdeText*)element;
+      Block block;
+      block.page_num = page_num;
+      block.bbox = element->GetBBox();
+      block.heading_level = GetHeadingLevel(text->GetTextStyle());
+      block.text = text->GetText();
+      if (!block.text.empty())
+        blocks.push_back(std::move(block));
+      return;
+    }
+    default:
+      for (int i = 0; i < element->GetNumChildren(); i++) {
+        auto child = element->GetChild(i);
+        if (child)
+          GetElementBlocks(child, page_num, blocks);
+      }
+    }
+  }
+
+  void GetPageBlocks(PdfPage* page, std::vector<Block>& blocks) {
+    auto page_map_deleter = [](PdePageMap* page_map) { page_map->Release(); };
+    std::unique_ptr<PdePageMap, decltype(page_map_deleter)>
+      page_map(page->AcquirePageMap(), page_map_deleter);
+    if (!page_map)
+      throw PdfixException();
+    if (!page_map->CreateElements(nullptr, nullptr))
+      throw PdfixException();
+    auto element = page_map->GetElement();
+    if (!element)
+      throw PdfixException();
+    GetElementBlocks(element, page->GetNumber(), blocks);
+  }
+
+  Chunker::Chunker(size_t budget, BudgetUnit unit, const std::function<void(const Chunk&)>& emit)
+    : m_budget(std::max<size_t>(budget, 1)), m_unit(unit), m_emit(emit) {
+  }
+
+  size_t Chunker::Measure(const std::wstring& text, BudgetUnit unit) {
+    if (unit == kBudgetCharacters)
+      return text.length();
+    size_t words = 0;
+    bool in_word = false;
+    for (auto ch : text) {
+      bool space = std::iswspace(ch) != 0;
+      if (!space && !in_word)
+        words++;
+      in_word = !space;
+    }
+    return words;
+  }
+
+  void Chunker::Append(const Block& block, const std::wstring& text, size_t size) {
+    if (m_size > 0 && m_size + size > m_budget)
+      Flush();
+    if (!m_chunk.text.empty())
+      m_chunk.text += L'\n';
+    m_chunk.text += text;
+    m_size += size + (m_unit == kBudgetCharacters && m_size > 0 ? 1 : 0);
+
+    auto& regions = m_chunk.regions;
+    if (regions.empty() || regions.back().page_num != block.page_num) {
+      regions.push_back({ block.page_num, block.bbox });
+      return;
+    }
+    auto& bbox = regions.back().bbox;
+    bbox.left = std::min(bbox.left, block.bbox.left);
+    bbox.right = std::max(bbox.right, block.bbox.right);
+    bbox.bottom = std::min(bbox.bottom, block.bbox.bottom);
+    bbox.top = std::max(bbox.top, block.bbox.top);
+  }
+
+  void Chunker::Add(const Block& block) {
+    if (block.heading_level > 0) {
+      // a new section starts, headings of the same or lower level are closed
+      Flush();
+      m_headings.resize(std::min<size_t>(m_headings.size(), block.heading_level - 1));
+      m_headings.push_back(block.text);
+      return;
+    }
+
+    auto size = Measure(block.text, m_unit);
+    if (size <= m_budget) {
+      Append(block, block.text, size);
+      return;
+    }
+
+    // split long blocks at word boundaries
+    std::wstring part;
+    size_t part_size = 0;
+    size_t pos = 0;
+    while (pos < block.text.length()) {
+      auto end = block.text.find(L' ', pos + 1);
+      if (end == std::wstring::npos)
+        end = block.text.length();
+      auto word = block.text.substr(pos, end - pos);
+      auto word_size = Measure(word, m_unit);
+      if (part_size > 0 && part_size + word_size > m_budget) {
+        Append(block, part, part_size);
+        Flush();
+        part.clear();
+        part_size = 0;
+        // the separating space is not carried to the next part
+        if (!word.empty() && word[0] == L' ') {
+          word.erase(0, 1);
+          word_size = Measure(word, m_unit);
+        }
+      }
+      part += word;
+      part_size += word_size;
+      pos = end;
+    }
+    if (!part.empty())
+      Append(block, part, part_size);
+  }
+
+  void Chunker::Flush() {
+    if (m_chunk.text.empty())
+      return;
+    m_chunk.index = m_next_index++;
+    m_chunk.headings = m_headings;
+    m_emit(m_chunk);
+    m_chunk = Chunk();
+    m_size = 0;
+  }
+
+  void WriteChunk(const Chunk& chunk, std::ostream& output) {
+    ptree node;
+    node.put("index", chunk.index);
+    node.put("text", ToUtf8(chunk.text));
+    ptree headings_node;
+    for (auto& heading : chunk.headings) {
+      ptree heading_node;
+      heading_node.put("", ToUtf8(heading));
+      headings_node.push_back(std::make_pair("", heading_node));
+    }
+    node.put_child("headings", headings_node);
+    ptree regions_node;
+    for (auto& region : chunk.regions) {
+      ptree region_node;
+      region_node.put("page_num", region.page_num + 1);
+      ptree bbox_node;
+      for (auto value : { region.bbox.left, region.bbox.bottom, region.bbox.right, region.bbox.top }) {
+        ptree value_node;
+        value_node.put("", value);
+        bbox_node.push_back(std::make_pair("", value_node));
+      }
+      region_node.put_child("bbox", bbox_node);
+      regions_node.push_back(std::make_pair("", region_node));
+    }
+    node.put_child("regions", regions_node);
+    write_json(output, node, false);
+  }
+
+  void Run(
+    const std::wstring& open_path,        // source PDF document
+    std::ostream& output,                 // output stream
+    size_t budget,                        // max chunk size
+    BudgetUnit unit,                      // unit of the budget
+    size_t thread_count                   // max number of threads
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    auto num_pages = doc->GetNumPages();
+    if (thread_count == 0)
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    int workers = (int)std::min<size_t>(thread_count, std::max(num_pages, 0));
+    // pages extracted ahead of the chunker, bounds the memory on large documents
+    int window = workers * 2;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<int, std::vector<Block>> ready;
+    int next_consumed = 0;
+    bool stop = false;
+    std::exception_ptr error;
+    std::atomic<int> next_page(0);
+
+    // workers claim pages in order and wait while they are too far ahead of the chunker
+    auto extract_pages = [&](int, int) {
+      for (int i = next_page++; i < num_pages; i = next_page++) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [&]() { return stop || i < next_consumed + window; });
+          if (stop)
+            return;
+        }
+        std::vector<Block> blocks;
+        try {
+          auto page_deleter = [](PdfPage* page) { page->Release(); };
+          std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+          if (!page)
+            throw PdfixException();
+          GetPageBlocks(page.get(), blocks);
+        }
+        catch (...) {
+          // the page never becomes ready, other workers and the chunker must not wait for it
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error)
+            error = std::current_exception();
+          stop = true;
+          cv.notify_all();
+          throw;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.emplace(i, std::move(blocks));
+        cv.notify_all();
+      }
+    };
+    std::thread producer([&]() {
+      try {
+        ParallelFor(0, workers - 1, workers, extract_pages);
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error)
+          error = std::current_exception();
+        stop = true;
+        cv.notify_all();
+      }
+    });
+
+    // chunks are written as soon as the pages they come from are processed
+    Chunker chunker(budget, unit, [&](const Chunk& chunk) {
+      WriteChunk(chunk, output);
+      output.flush();
+    });
+    try {
+      for (int i = 0; i < num_pages; i++) {
+        std::vector<Block> blocks;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [&]() { return stop || ready.count(i) > 0; });
+          if (stop)
+            break;
+          blocks = std::move(ready[i]);
+          ready.erase(i);
+          next_consumed = i + 1;
+          cv.notify_all();
+        }
+        for (auto& block : blocks)
+          chunker.Add(block);
+      }
+      chunker.Flush();
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error)
+        error = std::current_exception();
+      stop = true;
+      cv.notify_all();
+    }
+    producer.join();
+    if (error)
+      std::rethrow_exception(error);
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+} // namespace TextChunks
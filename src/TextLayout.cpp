@@ -0,0 +1,432 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// TextLayout.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/TextLayout.h"
+
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <random>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace TextLayout {
+
+  // glyphs are measured at this size to keep the bbox precision
+  static const double kProbeFontSize = 1000.;
+
+  FontMetrics::FontMetrics(Pdfix* pdfix, const std::wstring& font_name, int font_flags)
+    : m_font_name(font_name), m_font_flags(font_flags), m_widths(0x10000, -1.f) {
+    // the document and the page are owned by the metrics only once construction succeeds, the
+    // page is released before the document is closed
+    auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+    std::unique_ptr<PdfDoc, decltype(doc_deleter)> doc(pdfix->CreateDoc(), doc_deleter);
+    if (!doc)
+      throw PdfixException();
+    m_doc = doc.get();
+
+    PdfRect media_box;
+    media_box.right = kProbeFontSize * 4;
+    media_box.top = kProbeFontSize * 2;
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::unique_ptr<PdfPage, decltype(page_deleter)> page(m_doc->CreatePage(-1, &media_box),
+      page_deleter);
+    if (!page)
+      throw PdfixException();
+    m_content = page->GetContent();
+    if (!m_content)
+      throw PdfixException();
+
+    auto sys_font = pdfix->FindSysFont(font_name.c_str(), font_flags, PdfFontCodepage::kFontDefANSICodepage);
+    if (!sys_font)
+      throw PdfixException();
+    m_font = m_doc->CreateFont(sys_font, PdfFontCharset::kFontAnsiCharset, 0);
+    sys_font->Destroy();
+    if (!m_font)
+      throw PdfixException();
+
+    // the bbox of a single glyph misses its side bearings, measured characters are placed
+    // between two letters and the width of the letters alone is subtracted
+    m_probe_width = MeasureText(L"HH");
+    m_page = page.release();
+    doc.release();
+  }
+
+  FontMetrics::~FontMetrics() {
+    if (m_page)
+      m_page->Release();
+    if (m_doc)
+      m_doc->Close();
+  }
+
+  double FontMetrics::MeasureText(const std::wstring& text) {
+    PdfMatrix matrix;
+    auto text_obj = m_content->AddNewText(-1, m_font, &matrix);
+    if (!text_obj)
+      throw PdfixException();
+    PdfTextState ts;
+    ts.font = m_font;
+    ts.font_size = kProbeFontSize;
+    ts.color_state.fill_type = kFillTypeSolid;
+    text_obj->SetTextState(&ts);
+    text_obj->SetText(text.c_str());
+    auto bbox = text_obj->GetBBox();
+    m_content->RemoveObject(text_obj);
+    return bbox.right - bbox.left;
+  }
+
+  double FontMetrics::Measure(wchar_t ch) {
+    std::wstring probe = L"H";
+    probe += ch;
+    probe += L'H';
+    double width = (MeasureText(probe) - m_probe_width) / kProbeFontSize;
+    if (width < 0)
+      width = 0;
+    if ((size_t)(unsigned)ch < m_widths.size())
+      m_widths[ch] = (float)width;
+    return width;
+  }
+
+  double FontMetrics::GetTextWidth(const wchar_t* text, size_t length, double font_size) {
+    double width = 0;
+    for (size_t i = 0; i < length; i++)
+      width += GetWidth(text[i]);
+    return width * font_size;
+  }
+
+  void BreakLines(const wchar_t* text, size_t length, FontMetrics& metrics, double font_size,
+    double max_width, std::vector<Line>& lines) {
+    lines.clear();
+
+    auto add_line = [&](size_t begin, size_t end, bool last) {
+      // trailing spaces are not drawn
+      while (end > begin && text[end - 1] == L' ')
+        end--;
+      Line line;
+      line.begin = begin;
+      line.end = end;
+      line.last = last;
+      for (size_t i = begin; i < end; i++) {
+        if (text[i] == L' ')
+          line.spaces++;
+      }
+      line.width = metrics.GetTextWidth(text + begin, end - begin, font_size);
+      lines.push_back(line);
+    };
+
+    const size_t npos = (size_t)-1;
+    size_t begin = 0;                     // first character of the current line
+    double width = 0;                     // width of the current line
+    size_t space = npos;                  // last space of the current line
+    double word_width = 0;                // width of characters after the last space
+    for (size_t i = 0; i < length; i++) {
+      wchar_t ch = text[i];
+      if (ch == L'\n') {
+        add_line(begin, i, true);
+        begin = i + 1;
+        width = word_width = 0;
+        space = npos;
+        continue;
+      }
+      if (ch == L' ' && i == begin) {
+        begin++;
+        continue;
+      }
+
+      double char_width = metrics.GetWidth(ch) * font_size;
+      if (ch != L' ' && width + char_width > max_width && i > begin) {
+        if (space != npos) {
+          add_line(begin, space, false);
+          begin = space + 1;
+          width = word_width;
+        }
+        else {
+          add_line(begin, i, false);
+          begin = i;
+          width = word_width = 0;
+        }
+        space = npos;
+      }
+
+      width += char_width;
+      if (ch == L' ') {
+        space = i;
+        word_width = 0;
+      }
+      else
+        word_width += char_width;
+    }
+    if (begin < length)
+      add_line(begin, length, true);
+  }
+
+  void GetColumns(const PdfRect& rect, int columns, double gap, std::vector<PdfRect>& column_rects) {
+    column_rects.clear();
+    if (columns < 1)
+      columns = 1;
+    double width = (rect.right - rect.left - gap * (columns - 1)) / columns;
+    for (int i = 0; i < columns; i++) {
+      PdfRect column = rect;
+      column.left = rect.left + i * (width + gap);
+      column.right = column.left + width;
+      column_rects.push_back(column);
+    }
+  }
+
+  TextFlow::TextFlow(EditContent::ResourceCache& cache, FontMetrics& metrics, const TextStyle& style,
+    const std::function<bool(TextFlow&)>& overflow)
+    : m_cache(cache), m_metrics(metrics), m_style(style), m_overflow(overflow) {
+    if (!m_metrics.IsFontOf(style))
+      throw std::runtime_error("Text style font differs from the font metrics");
+  }
+
+  void TextFlow::SetStyle(const TextStyle& style) {
+    if (!m_metrics.IsFontOf(style))
+      throw std::runtime_error("Text style font differs from the font metrics");
+    m_style = style;
+  }
+
+  void TextFlow::AddFrame(PdsContent* content, const PdfRect& rect) {
+    m_frames.push_back({ content, rect });
+  }
+
+  bool TextFlow::NextBaseline(double& baseline) {
+    while (true) {
+      if (m_frame == m_frames.size()) {
+        if (!m_overflow || !m_overflow(*this) || m_frame == m_frames.size())
+          return false;
+      }
+      auto& rect = m_frames[m_frame].rect;
+      baseline = m_frame_started
+        ? m_baseline - m_style.font_size * m_style.line_height
+        : rect.top - m_style.font_size;
+      if (baseline >= rect.bottom) {
+        m_baseline = baseline;
+        m_frame_started = true;
+        return true;
+      }
+      m_frame++;
+      m_frame_started = false;
+    }
+  }
+
+  bool TextFlow::AddParagraph(const std::wstring& text) {
+    if (m_frame == m_frames.size()) {
+      if (!m_overflow || !m_overflow(*this) || m_frame == m_frames.size())
+        return false;
+    }
+    // lines are broken to the width of the current frame, frames of a flow usually share it
+    auto& rect = m_frames[m_frame].rect;
+    BreakLines(text.c_str(), text.length(), m_metrics, m_style.font_size, rect.right - rect.left, m_lines);
+
+    auto font = m_cache.GetFont(m_style.font_name, m_style.font_flags);
+    PdfTextState ts;
+    ts.font = font;
+    ts.font_size = m_style.font_size;
+    ts.color_state.fill_color = m_cache.GetRGBColor(m_style.color[0], m_style.color[1], m_style.color[2]);
+    ts.color_state.fill_opacity = 255;
+    ts.color_state.fill_type = kFillTypeSolid;
+    ts.color_state.stroke_type = kFillTypeNone;
+
+    for (auto& line : m_lines) {
+      double baseline;
+      if (!NextBaseline(baseline))
+        return false;
+      auto& frame = m_frames[m_frame];
+      double free_space = frame.rect.right - frame.rect.left - line.width;
+
+      PdfMatrix matrix;
+      matrix.e = frame.rect.left;
+      matrix.f = baseline;
+      ts.word_spacing = 0;
+      switch (m_style.alignment) {
+      case kAlignRight:
+        matrix.e += free_space;
+        break;
+      case kAlignCenter:
+        matrix.e += free_space / 2;
+        break;
+      case kAlignJustify:
+        if (!line.last && line.spaces > 0)
+          ts.word_spacing = free_space / line.spaces;
+        break;
+      default:
+        break;
+      }
+
+      if (line.end == line.begin)
+        continue;
+      auto text_obj = frame.content->AddNewText(-1, font, &matrix);
+      if (!text_obj)
+        throw PdfixException();
+      m_line_text.assign(text, line.begin, line.end - line.begin);
+      text_obj->SetText(m_line_text.c_str());
+      text_obj->SetTextState(&ts);
+      m_line_count++;
+    }
+    if (m_frame_started)
+      m_baseline -= m_style.paragraph_spacing;
+    return true;
+  }
+
+  void CreateParagraphs(size_t count, std::vector<std::wstring>& paragraphs) {
+    static const wchar_t* words[] = { L"lorem", L"ipsum", L"dolor", L"sit", L"amet", L"consectetur",
+      L"adipiscing", L"elit", L"sed", L"do", L"eiusmod", L"tempor", L"incididunt", L"ut", L"labore",
+      L"et", L"dolore", L"magna", L"aliqua", L"enim", L"ad", L"minim", L"veniam", L"quis",
+      L"nostrud", L"exercitation", L"ullamco", L"laboris", L"nisi", L"aliquip", L"ex", L"ea",
+      L"commodo", L"consequat" };
+    const int word_count = sizeof(words) / sizeof(words[0]);
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int> word(0, word_count - 1);
+    std::uniform_int_distribution<int> length(20, 120);
+
+    for (size_t i = 0; i < count; i++) {
+      std::wstring paragraph;
+      int words_in_paragraph = length(random);
+      for (int j = 0; j < words_in_paragraph; j++) {
+        if (j > 0)
+          paragraph += L' ';
+        paragraph += words[word(random)];
+      }
+      paragraph += L'.';
+      paragraphs.push_back(paragraph);
+    }
+  }
+
+  // lays the paragraphs out into columns of as many A4 pages as needed
+  static size_t LayoutDocument(Pdfix* pdfix, PdfDoc* doc, FontMetrics& metrics,
+    const std::vector<std::wstring>& paragraphs, int columns, Alignment alignment) {
+    PdfRect media_box;
+    media_box.right = 595;
+    media_box.top = 842;
+    PdfRect body = media_box;
+    body.left += 50;
+    body.right -= 50;
+    body.bottom += 60;
+    body.top -= 60;
+
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::vector<std::unique_ptr<PdfPage, decltype(page_deleter)>> pages;
+    auto add_page = [&](TextFlow& flow) {
+      pages.emplace_back(doc->CreatePage(-1, &media_box), page_deleter);
+      if (!pages.back())
+        throw PdfixException();
+      std::vector<PdfRect> column_rects;
+      GetColumns(body, columns, 18, column_rects);
+      for (auto& rect : column_rects)
+        flow.AddFrame(pages.back()->GetContent(), rect);
+      return true;
+    };
+
+    EditContent::ResourceCache cache(pdfix, doc);
+    TextStyle style;
+    style.alignment = alignment;
+    TextFlow flow(cache, metrics, style, add_page);
+    for (auto& paragraph : paragraphs) {
+      if (!flow.AddParagraph(paragraph))
+        throw std::runtime_error("Paragraph does not fit");
+    }
+
+    for (auto& page : pages) {
+      if (!page->SetContent())
+        throw PdfixException();
+    }
+    return flow.GetNumLines();
+  }
+
+  void Run(
+    const std::wstring& save_path,        // output PDF document
+    size_t paragraph_count,               // number of sample paragraphs
+    int columns,                          // number of columns on each page
+    Alignment alignment                   // alignment of the paragraphs
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    std::vector<std::wstring> paragraphs;
+    CreateParagraphs(paragraph_count, paragraphs);
+
+    {
+      FontMetrics metrics(pdfix, TextStyle().font_name, TextStyle().font_flags);
+      auto doc = pdfix->CreateDoc();
+      if (!doc)
+        throw PdfixException();
+      LayoutDocument(pdfix, doc, metrics, paragraphs, columns, alignment);
+      if (!doc->Save(save_path.c_str(), kSaveFull))
+        throw PdfixException();
+      doc->Close();
+    }
+
+    pdfix->Destroy();
+  }
+
+  void Benchmark(
+    size_t paragraph_count,               // number of sample paragraphs
+    std::ostream& output                  // output stream for the report
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    std::vector<std::wstring> paragraphs;
+    CreateParagraphs(paragraph_count, paragraphs);
+
+    auto report = [&](const char* stage, double seconds, size_t lines) {
+      output << stage << ": " << paragraphs.size() << " paragraphs, " << lines << " lines in "
+        << seconds << " s";
+      if (seconds > 0)
+        output << " (" << paragraphs.size() / seconds << " paragraphs/s)";
+      output << std::endl;
+    };
+
+    {
+      FontMetrics metrics(pdfix, TextStyle().font_name, TextStyle().font_flags);
+
+      // the first pass fills the glyph width cache
+      auto clock_start = std::chrono::steady_clock::now();
+      std::vector<Line> lines;
+      size_t line_count = 0;
+      for (auto& paragraph : paragraphs) {
+        BreakLines(paragraph.c_str(), paragraph.length(), metrics, 10, 225, lines);
+        line_count += lines.size();
+      }
+      auto clock_end = std::chrono::steady_clock::now();
+      report("line breaking, cold cache", std::chrono::duration<double>(clock_end - clock_start).count(),
+        line_count);
+
+      clock_start = std::chrono::steady_clock::now();
+      line_count = 0;
+      for (auto& paragraph : paragraphs) {
+        BreakLines(paragraph.c_str(), paragraph.length(), metrics, 10, 225, lines);
+        line_count += lines.size();
+      }
+      clock_end = std::chrono::steady_clock::now();
+      report("line breaking", std::chrono::duration<double>(clock_end - clock_start).count(), line_count);
+
+      clock_start = std::chrono::steady_clock::now();
+      auto doc = pdfix->CreateDoc();
+      if (!doc)
+        throw PdfixException();
+      line_count = LayoutDocument(pdfix, doc, metrics, paragraphs, 2, kAlignJustify);
+      doc->Close();
+      clock_end = std::chrono::steady_clock::now();
+      report("layout with text objects", std::chrono::duration<double>(clock_end - clock_start).count(),
+        line_count);
+    }
+
+    pdfix->Destroy();
+  }
+} // namespace TextLayout
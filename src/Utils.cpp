@@ -9,6 +9,12 @@
 #include <locale.h>
 #include <codecvt>
 #include <math.h>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <cstdint>
 #ifdef _WIN32
 #include <Windows.h>
 #include <Shlobj.h>
@@ -84,6 +90,37 @@ std::string ToUtf8(const std::wstring& str) {
   return result;
 }
 
+void AppendUtf8(const std::wstring& str, std::string& output) {
+  for (size_t i = 0; i < str.length(); i++) {
+    uint32_t ch = (uint32_t)str[i];
+    // combine UTF-16 surrogate pairs where wchar_t is 16-bit
+    if (sizeof(wchar_t) == 2 && ch >= 0xD800 && ch <= 0xDBFF && i + 1 < str.length()) {
+      uint32_t low = (uint32_t)str[i + 1];
+      if (low >= 0xDC00 && low <= 0xDFFF) {
+        ch = 0x10000 + ((ch - 0xD800) << 10) + (low - 0xDC00);
+        i++;
+      }
+    }
+    if (ch < 0x80)
+      output += (char)ch;
+    else if (ch < 0x800) {
+      output += (char)(0xC0 | (ch >> 6));
+      output += (char)(0x80 | (ch & 0x3F));
+    }
+    else if (ch < 0x10000) {
+      output += (char)(0xE0 | (ch >> 12));
+      output += (char)(0x80 | ((ch >> 6) & 0x3F));
+      output += (char)(0x80 | (ch & 0x3F));
+    }
+    else {
+      output += (char)(0xF0 | (ch >> 18));
+      output += (char)(0x80 | ((ch >> 12) & 0x3F));
+      output += (char)(0x80 | ((ch >> 6) & 0x3F));
+      output += (char)(0x80 | (ch & 0x3F));
+    }
+  }
+}
+
 std::string GetAbsolutePath(const std::string& path) {
   std::string result;
 #ifndef _WIN32
@@ -236,3 +273,58 @@ void PdfMatrixInverse(PdfMatrix& m, PdfMatrix& m1) {
   inverse.e = (orig.c * orig.f - orig.d * orig.e) / i;
   inverse.f = (orig.a * orig.f - orig.b * orig.e) / j;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HashBytes
+////////////////////////////////////////////////////////////////////////////////////////////////////
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash) {
+  auto bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ParallelFor
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void ParallelFor(int from, int to, size_t thread_count, const std::function<void(int, int)>& process) {
+  if (to < from)
+    return;
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&](int range_from, int range_to) {
+    try {
+      process(range_from, range_to);
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error)
+        error = std::current_exception();
+    }
+  };
+
+  auto div_round_up = [](auto a, auto b) {
+    return (a + b - 1) / b;
+  };
+
+  std::vector<std::thread> workers;
+  int last = from;
+  while (last <= to) {
+    size_t available_threads = thread_count - workers.size();
+    size_t left = to - last + 1;
+    int count = (int)div_round_up(left, available_threads);
+    workers.emplace_back(worker, last, last + count - 1);
+    last += count;
+  }
+
+  for (auto& w : workers)
+    w.join();
+
+  if (error)
+    std::rethrow_exception(error);
+}
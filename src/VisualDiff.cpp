@@ -0,0 +1,286 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// VisualDiff.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/VisualDiff.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <boost/property_tree/json_parser.hpp>
+#include "pdfixsdksamples/PageFingerprint.h"
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+using namespace boost::property_tree;
+
+namespace VisualDiff {
+
+  int DiffPixels(const uint8_t* old_pixels, const uint8_t* new_pixels, int width, int height,
+    int tolerance, int tile_size, std::vector<int>& tile_counts) {
+    int cols = (width + tile_size - 1) / tile_size;
+    int rows = (height + tile_size - 1) / tile_size;
+    tile_counts.assign(cols * rows, 0);
+
+    int changed = 0;
+    for (int y = 0; y < height; y++) {
+      auto old_row = old_pixels + (size_t)y * width * 4;
+      auto new_row = new_pixels + (size_t)y * width * 4;
+      auto tile_row = &tile_counts[(y / tile_size) * cols];
+      for (int tx = 0; tx < cols; tx++) {
+        int from = tx * tile_size;
+        int to = std::min(from + tile_size, width);
+        // branch free loop over the tile span, vectorized by the compiler
+        int count = 0;
+        for (int x = from * 4; x < to * 4; x += 4) {
+          int d0 = std::abs(old_row[x] - new_row[x]);
+          int d1 = std::abs(old_row[x + 1] - new_row[x + 1]);
+          int d2 = std::abs(old_row[x + 2] - new_row[x + 2]);
+          int d3 = std::abs(old_row[x + 3] - new_row[x + 3]);
+          count += std::max(std::max(d0, d1), std::max(d2, d3)) > tolerance;
+        }
+        tile_row[tx] += count;
+        changed += count;
+      }
+    }
+    return changed;
+  }
+
+  void GetChangedRegions(const std::vector<int>& tile_counts, int width, int height, int tile_size,
+    std::vector<PdfDevRect>& regions) {
+    int cols = (width + tile_size - 1) / tile_size;
+    int rows = (height + tile_size - 1) / tile_size;
+    std::vector<bool> visited(tile_counts.size(), false);
+    std::vector<int> stack;
+    for (int start = 0; start < (int)tile_counts.size(); start++) {
+      if (visited[start] || tile_counts[start] == 0)
+        continue;
+      // flood fill of 8-connected changed tiles
+      int min_col = cols, max_col = -1, min_row = rows, max_row = -1;
+      stack.push_back(start);
+      visited[start] = true;
+      while (!stack.empty()) {
+        int tile = stack.back();
+        stack.pop_back();
+        int col = tile % cols, row = tile / cols;
+        min_col = std::min(min_col, col);
+        max_col = std::max(max_col, col);
+        min_row = std::min(min_row, row);
+        max_row = std::max(max_row, row);
+        for (int r = std::max(row - 1, 0); r <= std::min(row + 1, rows - 1); r++) {
+          for (int c = std::max(col - 1, 0); c <= std::min(col + 1, cols - 1); c++) {
+            int next = r * cols + c;
+            if (!visited[next] && tile_counts[next] > 0) {
+              visited[next] = true;
+              stack.push_back(next);
+            }
+          }
+        }
+      }
+      PdfDevRect rect;
+      rect.left = min_col * tile_size;
+      rect.top = min_row * tile_size;
+      rect.right = std::min((max_col + 1) * tile_size, width);
+      rect.bottom = std::min((max_row + 1) * tile_size, height);
+      regions.push_back(rect);
+    }
+  }
+
+  // rendered page with its pixels
+  struct PageBitmap {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+  };
+
+  static void RenderPage(PdfPage* page, PdfPageView* page_view, PageBitmap& bitmap,
+    PsImage** keep_image = nullptr) {
+    bitmap.width = page_view->GetDeviceWidth();
+    bitmap.height = page_view->GetDeviceHeight();
+    PsImage* image = GetPdfix()->CreateImage(bitmap.width, bitmap.height, kImageDIBFormatArgb);
+    if (!image)
+      throw PdfixException();
+
+    PdfPageRenderParams params;
+    params.image = image;
+    page_view->GetDeviceMatrix(&params.matrix);
+    params.render_flags = kRenderAnnot;
+    if (!page->DrawContent(&params, nullptr, nullptr))
+      throw PdfixException();
+
+    // 32-bit pixels without row padding
+    auto stm = image->GetDataStm();
+    if (!stm)
+      throw PdfixException();
+    bitmap.pixels.resize((size_t)bitmap.width * bitmap.height * 4);
+    if (!stm->Read(0, bitmap.pixels.data(), (int)bitmap.pixels.size()))
+      throw PdfixException();
+
+    if (keep_image)
+      *keep_image = image;
+    else
+      image->Destroy();
+  }
+
+  // tints changed regions red and saves the image
+  static void SaveOverlay(PsImage* image, PageBitmap& bitmap, const std::vector<PdfDevRect>& regions,
+    const std::wstring& path) {
+    for (auto& rect : regions) {
+      for (int y = rect.top; y < rect.bottom; y++) {
+        auto row = &bitmap.pixels[((size_t)y * bitmap.width + rect.left) * 4];
+        for (int x = 0; x < rect.right - rect.left; x++) {
+          // BGRA byte order
+          row[x * 4] = (uint8_t)(row[x * 4] / 2);
+          row[x * 4 + 1] = (uint8_t)(row[x * 4 + 1] / 2);
+          row[x * 4 + 2] = (uint8_t)(128 + row[x * 4 + 2] / 2);
+        }
+      }
+    }
+    auto stm = image->GetDataStm();
+    if (!stm || !stm->Write(0, bitmap.pixels.data(), (int)bitmap.pixels.size()))
+      throw PdfixException();
+    PdfImageParams img_params;
+    img_params.format = kImageFormatPng;
+    if (!image->Save(path.c_str(), &img_params))
+      throw PdfixException();
+  }
+
+  void ComparePages(PdfDoc* old_doc, PdfDoc* new_doc, double zoom, int tolerance,
+    const std::wstring& overlay_dir, size_t thread_count, std::vector<PageDiff>& diffs) {
+    const int tile_size = 16;
+    auto old_count = old_doc->GetNumPages();
+    auto new_count = new_doc->GetNumPages();
+    auto num_pages = std::max(old_count, new_count);
+    diffs.assign(num_pages, PageDiff());
+
+    auto compare_pages = [&](int from, int to) {
+      PageHasher old_hasher, new_hasher;
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      auto page_view_deleter = [](PdfPageView* page_view) { page_view->Release(); };
+      for (int i = from; i <= to; i++) {
+        auto& diff = diffs[i];
+        diff.page_num = i;
+        if (i >= old_count || i >= new_count) {
+          diff.status = i >= old_count ? kPageAdded : kPageRemoved;
+          continue;
+        }
+
+        std::unique_ptr<PdfPage, decltype(page_deleter)> old_page(old_doc->AcquirePage(i), page_deleter);
+        std::unique_ptr<PdfPage, decltype(page_deleter)> new_page(new_doc->AcquirePage(i), page_deleter);
+        if (!old_page || !new_page)
+          throw PdfixException();
+
+        // identical content renders identically
+        if (old_hasher.GetFingerprint(old_page.get()) == new_hasher.GetFingerprint(new_page.get())) {
+          diff.status = kPageIdentical;
+          continue;
+        }
+
+        std::unique_ptr<PdfPageView, decltype(page_view_deleter)>
+          old_view(old_page->AcquirePageView(zoom, kRotate0), page_view_deleter);
+        std::unique_ptr<PdfPageView, decltype(page_view_deleter)>
+          new_view(new_page->AcquirePageView(zoom, kRotate0), page_view_deleter);
+        if (!old_view || !new_view)
+          throw PdfixException();
+
+        PageBitmap old_bitmap, new_bitmap;
+        PsImage* new_image = nullptr;
+        RenderPage(old_page.get(), old_view.get(), old_bitmap);
+        RenderPage(new_page.get(), new_view.get(), new_bitmap, &new_image);
+        auto image_deleter = [](PsImage* image) { image->Destroy(); };
+        std::unique_ptr<PsImage, decltype(image_deleter)> new_image_ptr(new_image, image_deleter);
+
+        std::vector<PdfDevRect> dev_regions;
+        if (old_bitmap.width != new_bitmap.width || old_bitmap.height != new_bitmap.height) {
+          // page size changed, the whole page differs
+          diff.changed_pixels = new_bitmap.width * new_bitmap.height;
+          dev_regions.push_back({ 0, 0, new_bitmap.width, new_bitmap.height });
+        }
+        else {
+          std::vector<int> tile_counts;
+          diff.changed_pixels = DiffPixels(old_bitmap.pixels.data(), new_bitmap.pixels.data(),
+            new_bitmap.width, new_bitmap.height, tolerance, tile_size, tile_counts);
+          GetChangedRegions(tile_counts, new_bitmap.width, new_bitmap.height, tile_size, dev_regions);
+        }
+
+        diff.status = diff.changed_pixels ? kPageChanged : kPageUnchanged;
+        for (auto& dev_rect : dev_regions) {
+          PdfRect rect;
+          new_view->RectToPage(&dev_rect, &rect);
+          diff.regions.push_back(rect);
+        }
+
+        if (diff.changed_pixels && !overlay_dir.empty()) {
+          auto path = overlay_dir + L"/VisualDiff_page" + std::to_wstring(i + 1) + L".png";
+          SaveOverlay(new_image, new_bitmap, dev_regions, path);
+        }
+      }
+    };
+    ParallelFor(0, num_pages - 1, thread_count, compare_pages);
+  }
+
+  void Run(
+    const std::wstring& old_path,         // original PDF document
+    const std::wstring& new_path,         // revised PDF document
+    double zoom,                          // rendering zoom
+    int tolerance,                        // max channel difference of equal pixels
+    const std::wstring& overlay_dir,      // directory for overlay images, empty for none
+    std::ostream& output,                 // output stream for the JSON report
+    size_t thread_count                   // max number of threads
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* old_doc = pdfix->OpenDoc(old_path.c_str(), L"");
+    if (!old_doc)
+      throw PdfixException();
+    PdfDoc* new_doc = pdfix->OpenDoc(new_path.c_str(), L"");
+    if (!new_doc)
+      throw PdfixException();
+
+    std::vector<PageDiff> diffs;
+    ComparePages(old_doc, new_doc, zoom, tolerance, overlay_dir, thread_count, diffs);
+
+    const char* status_names[] = { "identical", "unchanged", "changed", "added", "removed" };
+    int changed_pages = 0;
+    ptree pages_node;
+    for (auto& diff : diffs) {
+      ptree page_node;
+      page_node.put("page_num", diff.page_num + 1);
+      page_node.put("status", status_names[diff.status]);
+      if (diff.status == kPageChanged) {
+        changed_pages++;
+        page_node.put("changed_pixels", diff.changed_pixels);
+        ptree regions_node;
+        for (auto& rect : diff.regions) {
+          ptree rect_node;
+          rect_node.put("left", rect.left);
+          rect_node.put("bottom", rect.bottom);
+          rect_node.put("right", rect.right);
+          rect_node.put("top", rect.top);
+          regions_node.push_back(std::make_pair("", rect_node));
+        }
+        page_node.put_child("regions", regions_node);
+      }
+      else if (diff.status == kPageAdded || diff.status == kPageRemoved)
+        changed_pages++;
+      pages_node.push_back(std::make_pair("", page_node));
+    }
+    ptree root;
+    root.put("changed_pages", changed_pages);
+    root.put_child("pages", pages_node);
+    write_json(output, root);
+
+    new_doc->Close();
+    old_doc->Close();
+    pdfix->Destroy();
+  }
+} // namespace VisualDiff
@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ZonalExtraction.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ZonalExtraction.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <boost/property_tree/json_parser.hpp>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace ZonalExtraction {
+
+  WordIndex::WordIndex(const PdfRect& bounds, double cell_size)
+    : m_bounds(bounds), m_cell_size(cell_size) {
+    m_cols = std::max(1, (int)std::ceil((bounds.right - bounds.left) / cell_size));
+    m_rows = std::max(1, (int)std::ceil((bounds.top - bounds.bottom) / cell_size));
+    m_cells.resize(m_cols * m_rows);
+  }
+
+  void WordIndex::GetCellRange(const PdfRect& rect, int& col_from, int& row_from,
+    int& col_to, int& row_to) const {
+    auto clamp = [](int value, int max) { return std::max(0, std::min(value, max - 1)); };
+    col_from = clamp((int)std::floor((rect.left - m_bounds.left) / m_cell_size), m_cols);
+    col_to = clamp((int)std::floor((rect.right - m_bounds.left) / m_cell_size), m_cols);
+    row_from = clamp((int)std::floor((rect.bottom - m_bounds.bottom) / m_cell_size), m_rows);
+    row_to = clamp((int)std::floor((rect.top - m_bounds.bottom) / m_cell_size), m_rows);
+  }
+
+  void WordIndex::Add(const PdfRect& bbox) {
+    int index = (int)m_bboxes.size();
+    m_bboxes.push_back(bbox);
+    int col_from, row_from, col_to, row_to;
+    GetCellRange(bbox, col_from, row_from, col_to, row_to);
+    for (int row = row_from; row <= row_to; row++)
+      for (int col = col_from; col <= col_to; col++)
+        m_cells[row * m_cols + col].push_back(index);
+  }
+
+  void WordIndex::Query(const PdfRect& rect, std::vector<int>& words) const {
+    int col_from, row_from, col_to, row_to;
+    GetCellRange(rect, col_from, row_from, col_to, row_to);
+    for (int row = row_from; row <= row_to; row++) {
+      for (int col = col_from; col <= col_to; col++) {
+        for (auto index : m_cells[row * m_cols + col]) {
+          auto& bbox = m_bboxes[index];
+          auto x = (bbox.left + bbox.right) / 2;
+          auto y = (bbox.bottom + bbox.top) / 2;
+          if (x >= rect.left && x <= rect.right && y >= rect.bottom && y <= rect.top)
+            words.push_back(index);
+        }
+      }
+    }
+    // words spanning several cells are found repeatedly, keep the reading order
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+  }
+
+  static PdfRect QuadToRect(const PdfQuad& quad) {
+    PdfRect rect;
+    rect.left = std::min({ quad.tl.x, quad.tr.x, quad.bl.x, quad.br.x });
+    rect.right = std::max({ quad.tl.x, quad.tr.x, quad.bl.x, quad.br.x });
+    rect.bottom = std::min({ quad.tl.y, quad.tr.y, quad.bl.y, quad.br.y });
+    rect.top = std::max({ quad.tl.y, quad.tr.y, quad.bl.y, quad.br.y });
+    return rect;
+  }
+
+  void ExtractPageZones(PdfPage* page, const std::vector<Zone>& zones, ptree& node) {
+    auto page_num = page->GetNumber();
+    std::vector<const Zone*> page_zones;
+    for (auto& zone : zones) {
+      if (zone.page_num == -1 || zone.page_num == page_num)
+        page_zones.push_back(&zone);
+    }
+    if (page_zones.empty())
+      return;
+
+    auto word_list_deleter = [](PdsWordList* word_list) { word_list->Release(); };
+    std::unique_ptr<PdsWordList, decltype(word_list_deleter)>
+      word_list(page->AcquireWordList(kWordFinderAlgLatest), word_list_deleter);
+    if (!word_list)
+      throw PdfixException();
+
+    // index words of the page
+    WordIndex index(page->GetCropBox(), 36.);
+    std::vector<std::wstring> texts;
+    int word_count = word_list->GetNumWords();
+    texts.reserve(word_count);
+    for (int i = 0; i < word_count; i++) {
+      auto word = word_list->GetWord(i);
+      if (!word)
+        throw PdfixException();
+      texts.push_back(word->GetText());
+      index.Add(QuadToRect(word->GetQuad()));
+    }
+
+    ptree zones_node;
+    for (auto zone : page_zones) {
+      std::vector<int> words;
+      index.Query(zone->rect, words);
+      std::wstring text;
+      for (auto word : words) {
+        if (!text.empty())
+          text += L' ';
+        text += texts[word];
+      }
+      zones_node.put(ptree::path_type(zone->name, '\0'), ToUtf8(text));
+    }
+
+    node.put("page_num", page_num + 1);
+    node.put_child("zones", zones_node);
+  }
+
+  void ExtractDocumentZones(PdfDoc* doc, const std::vector<Zone>& zones, ptree& node) {
+    // only pages referenced by zones are processed
+    int last_page = doc->GetNumPages() - 1;
+    bool all_pages = std::any_of(zones.begin(), zones.end(),
+      [](const Zone& zone) { return zone.page_num == -1; });
+    if (!all_pages) {
+      int max_page = -1;
+      for (auto& zone : zones)
+        max_page = std::max(max_page, zone.page_num);
+      last_page = std::min(last_page, max_page);
+    }
+
+    ptree pages_node;
+    for (int i = 0; i <= last_page; i++) {
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+
+      ptree page_node;
+      ExtractPageZones(page.get(), zones, page_node);
+      if (page_node.size())
+        pages_node.push_back(std::make_pair("", page_node));
+    }
+    node.put_child("pages", pages_node);
+  }
+
+  void Run(
+    const std::vector<std::wstring>& open_paths,   // source PDF documents with the same layout
+    const std::vector<Zone>& zones,                // zones of the page template
+    std::ostream& output,                          // output stream
+    size_t thread_count                            // max number of threads
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    // each worker processes its own set of documents
+    std::vector<ptree> doc_nodes(open_paths.size());
+    auto extract_docs = [&](int from, int to) {
+      for (int i = from; i <= to; i++) {
+        auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+        std::unique_ptr<PdfDoc, decltype(doc_deleter)>
+          doc(pdfix->OpenDoc(open_paths[i].c_str(), L""), doc_deleter);
+        if (!doc)
+          throw PdfixException();
+
+        auto& doc_node = doc_nodes[i];
+        doc_node.put("path", ToUtf8(open_paths[i]));
+        ExtractDocumentZones(doc.get(), zones, doc_node);
+      }
+    };
+    ParallelFor(0, (int)open_paths.size() - 1, thread_count, extract_docs);
+
+    ptree docs_node;
+    for (auto& doc_node : doc_nodes)
+      docs_node.push_back(std::make_pair("", doc_node));
+    ptree root;
+    root.put_child("documents", docs_node);
+    write_json(output, root);
+
+    pdfix->Destroy();
+  }
+} // namespace ZonalExtraction